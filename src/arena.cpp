@@ -0,0 +1,39 @@
+#include "arena.h"
+#include <algorithm>
+
+void* Memory::Arena::allocate(size_t size, size_t alignment) {
+	if (!this->blocks.empty()) {
+		const uintptr_t base = (uintptr_t)this->blocks.back().get();
+		const size_t offset = ((base + this->used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+		if (offset + size <= this->blockSizes.back()) {
+			this->used = offset + size;
+			this->bytes += size;
+			return this->blocks.back().get() + offset;
+		}
+	}
+
+	// anything bigger than a block gets a block of its own size
+	const size_t blockSize = std::max(blockBytes, size + alignment);
+	this->blocks.push_back(std::make_unique<std::byte[]>(blockSize));
+	this->blockSizes.push_back(blockSize);
+	const uintptr_t base = (uintptr_t)this->blocks.back().get();
+	const size_t offset = ((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+	this->used = offset + size;
+	this->bytes += size;
+	return this->blocks.back().get() + offset;
+}
+
+void Memory::Arena::reset() {
+	for (Destructor* d = this->destructors; d; d = d->next) {
+		d->destroy(d->object);
+	}
+	this->destructors = nullptr;
+
+	if (this->blocks.size() > 1) {
+		this->blocks.resize(1);
+		this->blockSizes.resize(1);
+	}
+	this->used = 0;
+	this->allocations = 0;
+	this->bytes = 0;
+}
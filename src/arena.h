@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Memory {
+	/*
+	* Bump allocator for things that live and die together, like every widget and config of
+	* one screen. Objects are placed into blocks back to back and never freed one by one.
+	* The ones with a destructor are linked in a list that reset() walks newest first, then
+	* all blocks but the first are released at once. Nothing built in an arena may be deleted.
+	*/
+	class Arena {
+	private:
+		struct Destructor {
+			void (*destroy)(void*);
+			void* object;
+			Destructor* next;
+		};
+
+		std::vector<std::unique_ptr<std::byte[]>> blocks;
+		std::vector<size_t> blockSizes;
+		size_t used;
+		Destructor* destructors;
+		size_t allocations;
+		size_t bytes;
+
+		void* allocate(size_t size, size_t alignment);
+	public:
+		static constexpr size_t blockBytes = 64 * 1024;
+
+		Arena() : blocks(), blockSizes(), used(0), destructors(nullptr), allocations(0), bytes(0) {}
+		~Arena() { this->reset(); }
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		template <typename T, typename... Args>
+		T* make(Args&&... args) {
+			T* res = new (this->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			if constexpr (!std::is_trivially_destructible_v<T>) {
+				Destructor* destructor = new (this->allocate(sizeof(Destructor), alignof(Destructor))) Destructor;
+				destructor->destroy = [](void* object) { ((T*)object)->~T(); };
+				destructor->object = res;
+				destructor->next = this->destructors;
+				this->destructors = destructor;
+			}
+			this->allocations++;
+			return res;
+		}
+
+		// destroys everything made so far, the first block is kept for the next build
+		void reset();
+
+		// objects made since the last reset and the bytes they take
+		size_t getAllocations() const { return this->allocations; }
+		size_t getBytes() const { return this->bytes; }
+		size_t getBlockCount() const { return this->blocks.size(); }
+	};
+}
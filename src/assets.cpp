@@ -0,0 +1,196 @@
+#include "assets.h"
+#include "graphics.h"
+#include "atlas.h"
+#include "thread_pool.h"
+#include <fstream>
+#include <memory>
+#include <algorithm>
+
+Assets::Loader* Assets::Loader::instance = nullptr;
+
+void Assets::Loader::request(const std::string& name, Decode decode) {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		if (!this->requested.insert(name).second) {
+			return;
+		}
+	}
+	this->pending++;
+
+	Jobs::ThreadPool::getPool()->submit([this, name, decode]() {
+		sf::Clock clock;
+		Step step;
+		try {
+			step = decode();
+		}
+		catch (...) {
+			// load failures surface on the main thread, where a synchronous load would have thrown
+			std::exception_ptr error = std::current_exception();
+			step = [error]() -> bool { std::rethrow_exception(error); };
+		}
+
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->decoded.push_back({ name, step, clock.getElapsedTime() });
+		this->decodedSignal.notify_all();
+	});
+}
+
+void Assets::Loader::finish(Job& job) {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->done.insert(job.name);
+	}
+	DEBUG("Loaded " << job.name << " (decoded in " << job.decodeTime.asMilliseconds() << " ms), "
+		<< this->sinceStart.getElapsedTime().asMilliseconds() << " ms after startup");
+	if (--this->pending == 0) {
+		LOG("All assets loaded " << this->sinceStart.getElapsedTime().asMilliseconds() << " ms after startup.");
+	}
+}
+
+void Assets::Loader::fail(Job& job, const std::string& error) {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->failed[job.name] = error;
+	}
+	ERROR("Couldn't load " << job.name << ". " << error);
+	if (--this->pending == 0) {
+		LOG("All assets loaded " << this->sinceStart.getElapsedTime().asMilliseconds() << " ms after startup.");
+	}
+}
+
+bool Assets::Loader::pump(sf::Time budget) {
+	sf::Clock clock;
+	bool finished = false;
+	while (clock.getElapsedTime() < budget) {
+		Job job;
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			if (this->decoded.empty()) {
+				break;
+			}
+			job = std::move(this->decoded.front());
+			this->decoded.pop_front();
+		}
+
+		try {
+			if (!job.step()) {
+				std::lock_guard<std::mutex> guard(this->lock);
+				this->decoded.push_front(std::move(job));
+				continue;
+			}
+			this->finish(job);
+		}
+		catch (std::exception& e) {
+			this->fail(job, e.what());
+		}
+		finished = true;
+	}
+	return finished;
+}
+
+void Assets::Loader::require(const std::string& name) {
+	Job job;
+	{
+		std::unique_lock<std::mutex> guard(this->lock);
+		if (!this->requested.count(name) || this->done.count(name)) {
+			return;
+		}
+		if (this->failed.count(name)) {
+			throw std::runtime_error("Couldn't load " + name + ". " + this->failed[name]);
+		}
+		auto find = [this, &name]() {
+			return std::find_if(this->decoded.begin(), this->decoded.end(), [&name](const Job& j) { return j.name == name; });
+		};
+		this->decodedSignal.wait(guard, [&]() { return find() != this->decoded.end(); });
+		auto it = find();
+		job = std::move(*it);
+		this->decoded.erase(it);
+	}
+
+	while (!job.step()) {}
+	this->finish(job);
+}
+
+bool Assets::Loader::isReady(const std::string& name) {
+	std::lock_guard<std::mutex> guard(this->lock);
+	return this->done.count(name) > 0;
+}
+
+void Assets::Loader::frameShown() {
+	if (this->firstFrameShown) {
+		return;
+	}
+	this->firstFrameShown = true;
+	LOG("First frame " << this->sinceStart.getElapsedTime().asMilliseconds() << " ms after startup, "
+		<< this->pending.load() << " asset(s) still loading.");
+}
+
+namespace Assets {
+	// the pages are uploaded into textures of their full size one strip of rows per step
+	struct AtlasUpload {
+		Atlas::Atlas atlas;
+		std::vector<sf::Texture*> pages;
+		size_t page;
+		uint32_t row;
+
+		AtlasUpload(Atlas::Atlas&& atlas) : atlas(std::move(atlas)), pages({}), page(0), row(0) {}
+
+		bool step() {
+			if (this->page == this->atlas.pages.size()) {
+				Graphics::addAtlas(this->atlas, this->pages);
+				Graphics::Renderer::getRender()->rebindTextures();
+				return true;
+			}
+
+			const sf::Image& image = this->atlas.pages[this->page];
+			const sf::Vector2u size = image.getSize();
+			if (this->row == 0) {
+				this->pages.push_back(new sf::Texture());
+				if (!this->pages.back()->resize(size)) {
+					// addAtlas skips the page, its sprites keep the placeholder
+					ERROR("Couldn't create a texture for atlas page " << this->page << ".");
+					delete this->pages.back();
+					this->pages.back() = nullptr;
+					this->page++;
+					return false;
+				}
+			}
+
+			const uint32_t rows = std::min(uploadRows, size.y - this->row);
+			this->pages.back()->update(image.getPixelsPtr() + (size_t)this->row * size.x * 4, { size.x, rows }, { 0, this->row });
+			this->row += rows;
+			if (this->row >= size.y) {
+				this->page++;
+				this->row = 0;
+			}
+			return false;
+		}
+	};
+
+	// sf::Font reads from this for as long as it lives
+	static std::vector<char> mainFontData;
+}
+
+void Assets::requestTextures() {
+	Graphics::createPlaceholderTexture();
+	Loader::getLoader()->request(texturesAsset, []() -> Loader::Step {
+		auto upload = std::make_shared<AtlasUpload>(Atlas::build(Graphics::textureSources(), textureCacheDirectory));
+		return [upload]() { return upload->step(); };
+	});
+}
+
+void Assets::requestMainFont() {
+	Loader::getLoader()->request(mainFontAsset, []() -> Loader::Step {
+		const std::filesystem::path path = Graphics::mainFontPath();
+		if (path.empty()) {
+			return []() { return true; };
+		}
+		std::ifstream file(path, std::ios::binary);
+		auto data = std::make_shared<std::vector<char>>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		return [data]() {
+			mainFontData = std::move(*data);
+			Graphics::mainFont = new sf::Font(mainFontData.data(), mainFontData.size());
+			return true;
+		};
+	});
+}
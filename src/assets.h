@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include "../include/SFML/Graphics.hpp"
+
+namespace Assets {
+	constexpr const char* texturesAsset = "textures";
+	constexpr const char* mainFontAsset = "main font";
+	// rows of an atlas page uploaded per step, a 2048 wide strip of 128 rows is 1 MB
+	constexpr uint32_t uploadRows = 128;
+
+	/*
+	* Loads what the game needs at startup without holding up the window. Files are read and
+	* decoded on the thread pool, each decode hands back a step that has to run on the main
+	* thread, like uploading pixels or swapping a result into place. pump() runs those steps
+	* between frames until its budget is spent, a step returning false is called again on the
+	* next one, so a big upload goes out in strips. Until then sprites show the placeholder.
+	*/
+	class Loader {
+	public:
+		// runs on the main thread, true once it's done
+		using Step = std::function<bool()>;
+		// runs on a worker and returns the main thread's part
+		using Decode = std::function<Step()>;
+	private:
+		struct Job {
+			std::string name;
+			Step step;
+			sf::Time decodeTime;
+		};
+
+		static Loader* instance;
+
+		std::mutex lock;
+		std::condition_variable decodedSignal;
+		std::deque<Job> decoded;
+		std::set<std::string> requested;
+		std::set<std::string> done;
+		// whose step threw in pump, require throws for these instead of waiting
+		std::map<std::string, std::string> failed;
+		std::atomic<size_t> pending;
+
+		sf::Clock sinceStart;
+		bool firstFrameShown;
+
+		Loader() : decoded({}), requested({}), done({}), failed({}), pending(0), firstFrameShown(false) {}
+
+		Loader(const Loader&) = delete;
+		Loader& operator=(const Loader&) = delete;
+
+		void finish(Job& job);
+		void fail(Job& job, const std::string& error);
+	public:
+		static Loader* getLoader() {
+			if (!instance) {
+				instance = new Loader();
+			}
+			return instance;
+		}
+
+		void request(const std::string& name, Decode decode);
+		// returns whether anything finished, which is when the frame needs redrawing; an asset
+		// that fails is logged and whatever shows it keeps the placeholder
+		bool pump(sf::Time budget);
+		// waits for the asset and finishes it right away, does nothing for one never requested
+		void require(const std::string& name);
+		bool isReady(const std::string& name);
+		bool idle() const { return this->pending.load() == 0; }
+
+		// called once a frame is on screen, the first one reports the time to first frame
+		void frameShown();
+	};
+
+	// the texture atlas, uploaded uploadRows at a time and bound to everything built so far
+	void requestTextures();
+	void requestMainFont();
+}
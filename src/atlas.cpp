@@ -0,0 +1,261 @@
+#include "atlas.h"
+#include "logging.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+
+Atlas::RectPacker::RectPacker(uint32_t width, uint32_t height) : width(width), height(height), skyline({}) {
+	this->skyline.push_back({ 0, 0, width });
+}
+
+uint32_t Atlas::RectPacker::fitAt(size_t index, uint32_t rectWidth) const {
+	if (this->skyline[index].x + rectWidth > this->width) {
+		return UINT32_MAX;
+	}
+	uint32_t y = 0;
+	uint32_t left = rectWidth;
+	for (size_t i = index; left > 0; i++) {
+		if (i >= this->skyline.size()) {
+			return UINT32_MAX;
+		}
+		y = std::max(y, this->skyline[i].y);
+		left -= std::min(left, this->skyline[i].width);
+	}
+	return y;
+}
+
+bool Atlas::RectPacker::insert(uint32_t rectWidth, uint32_t rectHeight, sf::Vector2u& position) {
+	size_t best = SIZE_MAX;
+	uint32_t bestTop = UINT32_MAX;
+	uint32_t bestY = 0;
+	for (size_t i = 0; i < this->skyline.size(); i++) {
+		uint32_t y = this->fitAt(i, rectWidth);
+		if (y == UINT32_MAX || y + rectHeight > this->height) {
+			continue;
+		}
+		if (y + rectHeight < bestTop) {
+			best = i;
+			bestTop = y + rectHeight;
+			bestY = y;
+		}
+	}
+	if (best == SIZE_MAX) {
+		return false;
+	}
+
+	position = { this->skyline[best].x, bestY };
+	this->skyline.insert(this->skyline.begin() + best, { position.x, bestTop, rectWidth });
+
+	// the new segment covers the start of the ones after it
+	for (size_t i = best + 1; i < this->skyline.size();) {
+		const Segment& previous = this->skyline[i - 1];
+		Segment& segment = this->skyline[i];
+		const uint32_t previousEnd = previous.x + previous.width;
+		if (segment.x >= previousEnd) {
+			break;
+		}
+		const uint32_t overlap = previousEnd - segment.x;
+		if (segment.width <= overlap) {
+			this->skyline.erase(this->skyline.begin() + i);
+			continue;
+		}
+		segment.x += overlap;
+		segment.width -= overlap;
+		break;
+	}
+
+	for (size_t i = 1; i < this->skyline.size();) {
+		if (this->skyline[i - 1].y == this->skyline[i].y) {
+			this->skyline[i - 1].width += this->skyline[i].width;
+			this->skyline.erase(this->skyline.begin() + i);
+		}
+		else {
+			i++;
+		}
+	}
+	return true;
+}
+
+uint32_t Atlas::RectPacker::usedHeight() const {
+	uint32_t res = 0;
+	for (auto& segment : this->skyline) {
+		res = std::max(res, segment.y);
+	}
+	return res;
+}
+
+uint64_t Atlas::sourceKey(const std::vector<std::filesystem::path>& sources) {
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const void* data, size_t bytes) {
+		const uint8_t* p = (const uint8_t*)data;
+		for (size_t i = 0; i < bytes; i++) {
+			hash ^= p[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	const uint32_t layout[] = { cacheVersion, pageSize, padding };
+	mix(layout, sizeof(layout));
+	for (auto& source : sources) {
+		const std::string name = source.filename().string();
+		mix(name.data(), name.size() + 1);
+		std::ifstream file(source, std::ios::binary);
+		std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		const uint64_t size = bytes.size();
+		mix(&size, sizeof(size));
+		mix(bytes.data(), bytes.size());
+	}
+	return hash;
+}
+
+Atlas::Atlas Atlas::pack(const std::vector<std::filesystem::path>& sources) {
+	std::vector<sf::Image> images;
+	std::vector<std::string> names;
+	images.reserve(sources.size());
+	for (auto& source : sources) {
+		sf::Image image;
+		if (!image.loadFromFile(source)) {
+			ERROR("Couldn't load " << source.string() << ", it's left out of the atlas.");
+			continue;
+		}
+		images.push_back(std::move(image));
+		names.push_back(source.filename().string());
+	}
+
+	// tall images first keeps the skyline flat
+	std::vector<size_t> order(images.size());
+	std::iota(order.begin(), order.end(), (size_t)0);
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		const sf::Vector2u l = images[a].getSize();
+		const sf::Vector2u r = images[b].getSize();
+		if (l.y != r.y) return l.y > r.y;
+		if (l.x != r.x) return l.x > r.x;
+		return names[a] < names[b];
+	});
+
+	Atlas res;
+	std::vector<RectPacker> packers;
+	std::vector<sf::Vector2u> extents;
+	std::vector<sf::Vector2u> positions(images.size());
+	std::vector<uint32_t> pageOf(images.size());
+	for (size_t i : order) {
+		const sf::Vector2u size = images[i].getSize();
+		const uint32_t width = size.x + 2 * padding;
+		const uint32_t height = size.y + 2 * padding;
+
+		size_t page = 0;
+		while (page < packers.size() && !packers[page].insert(width, height, positions[i])) {
+			page++;
+		}
+		if (page == packers.size()) {
+			// anything larger than a page gets a page of its own size
+			packers.emplace_back(std::max(pageSize, width), std::max(pageSize, height));
+			extents.push_back({ 0, 0 });
+			packers.back().insert(width, height, positions[i]);
+		}
+		pageOf[i] = (uint32_t)page;
+		extents[page].x = std::max(extents[page].x, positions[i].x + width);
+		extents[page].y = std::max(extents[page].y, positions[i].y + height);
+	}
+
+	for (auto& extent : extents) {
+		res.pages.emplace_back(extent, sf::Color::Transparent);
+	}
+	for (size_t i = 0; i < images.size(); i++) {
+		const sf::Vector2u at = { positions[i].x + padding, positions[i].y + padding };
+		if (!res.pages[pageOf[i]].copy(images[i], at)) {
+			ERROR("Couldn't copy " << names[i] << " into the atlas.");
+			continue;
+		}
+		res.entries.emplace_back(names[i], pageOf[i], sf::IntRect({ (int)at.x, (int)at.y }, { (int)images[i].getSize().x, (int)images[i].getSize().y }));
+	}
+	return res;
+}
+
+namespace Atlas {
+	static std::string keyName(uint64_t key) {
+		std::ostringstream res;
+		res << "atlas_" << std::hex << std::setw(16) << std::setfill('0') << key;
+		return res.str();
+	}
+
+	static bool loadCache(const std::filesystem::path& directory, const std::string& prefix, Atlas& atlas) {
+		std::ifstream index(directory / (prefix + ".index"));
+		if (!index) {
+			return false;
+		}
+		uint32_t version = 0;
+		size_t pageCount = 0;
+		if (!(index >> version >> pageCount) || version != cacheVersion) {
+			return false;
+		}
+
+		Entry entry;
+		int x, y, w, h;
+		while (index >> entry.page >> x >> y >> w >> h) {
+			index.get();
+			if (!std::getline(index, entry.name) || entry.page >= pageCount) {
+				return false;
+			}
+			entry.rect = sf::IntRect({ x, y }, { w, h });
+			atlas.entries.push_back(entry);
+		}
+
+		atlas.pages.resize(pageCount);
+		for (size_t p = 0; p < pageCount; p++) {
+			if (!atlas.pages[p].loadFromFile(directory / (prefix + "_" + std::to_string(p) + ".png"))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static void saveCache(const std::filesystem::path& directory, const std::string& prefix, const Atlas& atlas) {
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+		for (size_t p = 0; p < atlas.pages.size(); p++) {
+			if (!atlas.pages[p].saveToFile(directory / (prefix + "_" + std::to_string(p) + ".png"))) {
+				ERROR("Couldn't cache the texture atlas in " << directory.string());
+				return;
+			}
+		}
+
+		// the index goes last, a cache without one is never read
+		std::ofstream index(directory / (prefix + ".index"), std::ios::trunc);
+		index << cacheVersion << ' ' << atlas.pages.size() << '\n';
+		for (auto& entry : atlas.entries) {
+			index << entry.page << ' ' << entry.rect.position.x << ' ' << entry.rect.position.y << ' '
+				<< entry.rect.size.x << ' ' << entry.rect.size.y << ' ' << entry.name << '\n';
+		}
+	}
+
+	static void removeStaleCaches(const std::filesystem::path& directory, const std::string& prefix) {
+		std::error_code error;
+		for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+			const std::string name = file.path().filename().string();
+			if (name.rfind("atlas_", 0) == 0 && name.rfind(prefix, 0) != 0) {
+				std::filesystem::remove(file.path(), error);
+			}
+		}
+	}
+}
+
+Atlas::Atlas Atlas::build(const std::vector<std::filesystem::path>& sources, const std::filesystem::path& cacheDirectory) {
+	std::vector<std::filesystem::path> sorted = sources;
+	std::sort(sorted.begin(), sorted.end());
+	const std::string prefix = keyName(sourceKey(sorted));
+
+	Atlas res;
+	if (loadCache(cacheDirectory, prefix, res)) {
+		DEBUG("Texture atlas " << prefix << " loaded from cache.");
+		return res;
+	}
+
+	res = pack(sorted);
+	LOG("Packed " << res.entries.size() << " textures into " << res.pages.size() << " atlas page(s).");
+	removeStaleCaches(cacheDirectory, prefix);
+	saveCache(cacheDirectory, prefix, res);
+	return res;
+}
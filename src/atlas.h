@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "../include/SFML/Graphics.hpp"
+
+namespace Atlas {
+	constexpr uint32_t pageSize = 2048;
+	// transparent gap around every image, so scaled sprites don't sample their neighbours
+	constexpr uint32_t padding = 2;
+	constexpr uint32_t cacheVersion = 1;
+
+	/*
+	* Skyline bottom-left packer. The skyline is the top edge of everything placed so far, a
+	* new rect goes where its top ends up lowest, leftmost on ties.
+	*/
+	class RectPacker {
+	private:
+		struct Segment {
+			uint32_t x;
+			uint32_t y;
+			uint32_t width;
+		};
+
+		uint32_t width;
+		uint32_t height;
+		std::vector<Segment> skyline;
+
+		// lowest y a rect of this width can sit at starting on segment index, UINT32_MAX if it runs off the page
+		uint32_t fitAt(size_t index, uint32_t rectWidth) const;
+	public:
+		RectPacker(uint32_t width, uint32_t height);
+
+		// false when the rect doesn't fit on this page anymore
+		bool insert(uint32_t rectWidth, uint32_t rectHeight, sf::Vector2u& position);
+		uint32_t usedHeight() const;
+	};
+
+	struct Entry {
+		std::string name;
+		uint32_t page;
+		sf::IntRect rect;
+
+		Entry() : name(""), page(0), rect() {}
+		Entry(const std::string& n, uint32_t p, const sf::IntRect& r) : name(n), page(p), rect(r) {}
+	};
+
+	struct Atlas {
+		std::vector<sf::Image> pages;
+		std::vector<Entry> entries;
+	};
+
+	// FNV-1a over every source's name and bytes, any edited, added or removed file gives a new key
+	uint64_t sourceKey(const std::vector<std::filesystem::path>& sources);
+
+	Atlas pack(const std::vector<std::filesystem::path>& sources);
+
+	/*
+	* Loads the atlas cached under the key of the sources, or packs them and caches the result
+	* for the next start. Caches of older keys are removed.
+	*/
+	Atlas build(const std::vector<std::filesystem::path>& sources, const std::filesystem::path& cacheDirectory);
+}
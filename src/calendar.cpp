@@ -0,0 +1,148 @@
+#include "calendar.h"
+#include "logging.h"
+
+namespace Calendar {
+	// calendar date of day 0
+	constexpr int startYear = 2025;
+	constexpr int startMonth = 7;
+	constexpr int startDay = 1;
+
+	static int64_t daysFromCivil(int y, unsigned m, unsigned d) {
+		y -= m <= 2;
+		const int64_t era = (y >= 0 ? y : y - 399) / 400;
+		const unsigned yoe = (unsigned)(y - era * 400);
+		const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+		const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+		return era * 146097 + (int64_t)doe - 719468;
+	}
+}
+
+Calendar::Date Calendar::dayToDate(uint32_t day) {
+	int64_t z = daysFromCivil(startYear, startMonth, startDay) + day + 719468;
+	const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	const unsigned doe = (unsigned)(z - era * 146097);
+	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const unsigned mp = (5 * doy + 2) / 153;
+
+	Date res;
+	res.day = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+	res.month = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+	res.year = (int)(yoe + era * 400) + (res.month <= 2);
+	return res;
+}
+
+std::string Calendar::Date::toString() const {
+	char buffer[16];
+	std::snprintf(buffer, sizeof(buffer), "%04d.%02u.%02u", this->year, this->month, this->day);
+	return buffer;
+}
+
+Calendar::TimingWheel::TimingWheel(uint32_t startDay) : freeHead(nil), today(startDay), scheduled(0) {
+	this->heads.fill(nil);
+}
+
+uint32_t Calendar::TimingWheel::allocate() {
+	if (this->freeHead != nil) {
+		uint32_t index = this->freeHead;
+		this->freeHead = this->nodes[index].next;
+		return index;
+	}
+	this->nodes.push_back({ Event(), nil, nil, 0, freeSlot });
+	return (uint32_t)this->nodes.size() - 1;
+}
+
+void Calendar::TimingWheel::release(uint32_t index) {
+	Node& n = this->nodes[index];
+	n.generation++;
+	n.slot = freeSlot;
+	n.prev = nil;
+	n.next = this->freeHead;
+	this->freeHead = index;
+}
+
+void Calendar::TimingWheel::link(uint32_t index) {
+	Node& n = this->nodes[index];
+	uint32_t diff = n.event.day ^ this->today;
+
+	uint8_t level = 0;
+	while (level < levels - 1 && diff >= (1u << (slotBits * (level + 1)))) {
+		level++;
+	}
+	n.slot = (uint16_t)(level * slotCount + ((n.event.day >> (slotBits * level)) & (slotCount - 1)));
+
+	n.prev = nil;
+	n.next = this->heads[n.slot];
+	if (n.next != nil) {
+		this->nodes[n.next].prev = index;
+	}
+	this->heads[n.slot] = index;
+}
+
+void Calendar::TimingWheel::unlink(uint32_t index) {
+	Node& n = this->nodes[index];
+	if (n.prev != nil) {
+		this->nodes[n.prev].next = n.next;
+	}
+	else {
+		this->heads[n.slot] = n.next;
+	}
+	if (n.next != nil) {
+		this->nodes[n.next].prev = n.prev;
+	}
+}
+
+Calendar::EventHandle Calendar::TimingWheel::schedule(uint32_t day, EventType type, uint32_t subject) {
+	// anything due today or earlier fires with the next advance
+	if (day <= this->today) {
+		day = this->today + 1;
+	}
+	if (day - this->today >= horizon) {
+		ERROR("Event is scheduled too far ahead: day " << day);
+		return EventHandle();
+	}
+
+	uint32_t index = this->allocate();
+	this->nodes[index].event = Event(day, type, subject);
+	this->link(index);
+	this->scheduled++;
+	return EventHandle(index, this->nodes[index].generation);
+}
+
+bool Calendar::TimingWheel::cancel(EventHandle handle) {
+	if (!handle.isValid() || handle.index >= this->nodes.size()) {
+		return false;
+	}
+	Node& n = this->nodes[handle.index];
+	if (n.generation != handle.generation || n.slot == freeSlot) {
+		return false;
+	}
+
+	this->unlink(handle.index);
+	this->release(handle.index);
+	this->scheduled--;
+	return true;
+}
+
+void Calendar::TimingWheel::cascade(uint8_t level) {
+	uint16_t slot = (uint16_t)(level * slotCount + ((this->today >> (slotBits * level)) & (slotCount - 1)));
+
+	uint32_t index;
+	while ((index = this->heads[slot]) != nil) {
+		this->unlink(index);
+		this->link(index);
+	}
+}
+
+bool Calendar::TimingWheel::popDue(Event& event) {
+	uint32_t index = this->heads[this->today & (slotCount - 1)];
+	if (index == nil) {
+		return false;
+	}
+
+	event = this->nodes[index].event;
+	this->unlink(index);
+	this->release(index);
+	this->scheduled--;
+	return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <string>
+
+namespace Calendar {
+	enum EventType : uint8_t {
+		CONTRACT_EXPIRY,
+		INJURY_RECOVERY,
+		FIXTURE,
+		BOARD_MEETING,
+		SEASON_END,
+		CUSTOM,
+		EVENT_TYPE_COUNT
+	};
+
+	struct Event {
+		uint32_t day;
+		EventType type;
+		uint32_t subject; // character, club or fixture index depending on the type
+
+		Event() : day(0), type(CUSTOM), subject(0) {}
+		Event(uint32_t d, EventType t, uint32_t s) : day(d), type(t), subject(s) {}
+	};
+
+	struct EventHandle {
+		uint32_t index;
+		uint32_t generation;
+
+		EventHandle() : index(UINT32_MAX), generation(0) {}
+		EventHandle(uint32_t i, uint32_t g) : index(i), generation(g) {}
+		bool isValid() const { return this->index != UINT32_MAX; }
+	};
+
+	struct Date {
+		int year;
+		uint8_t month;
+		uint8_t day;
+
+		std::string toString() const;
+	};
+
+	// day 0 is the first day of a new save
+	Date dayToDate(uint32_t day);
+
+	/*
+	* Hierarchical timing wheel with one day resolution. Level 0 has a slot per day for the
+	* next 64 days, every level above covers 64 times the span of the one below. Events sit in
+	* intrusive lists inside a pooled node array, so scheduling and cancelling are O(1), and
+	* an event is only touched again when its level cascades down or its day comes.
+	*/
+	class TimingWheel {
+	private:
+		static constexpr uint8_t slotBits = 6;
+		static constexpr uint32_t slotCount = 1 << slotBits;
+		static constexpr uint8_t levels = 4;
+		static constexpr uint32_t nil = UINT32_MAX;
+
+		struct Node {
+			Event event;
+			uint32_t prev;
+			uint32_t next;
+			uint32_t generation;
+			uint16_t slot; // level * slotCount + slot, nil when the node is free
+		};
+
+		std::vector<Node> nodes;
+		uint32_t freeHead;
+		std::array<uint32_t, levels * slotCount> heads;
+		uint32_t today;
+		size_t scheduled;
+
+		uint32_t allocate();
+		void release(uint32_t index);
+		void link(uint32_t index);
+		void unlink(uint32_t index);
+		void cascade(uint8_t level);
+		bool popDue(Event& event);
+
+	public:
+		static constexpr uint32_t horizon = 1u << (slotBits * levels);
+		static constexpr uint16_t freeSlot = UINT16_MAX;
+
+		explicit TimingWheel(uint32_t startDay = 0);
+
+		EventHandle schedule(uint32_t day, EventType type, uint32_t subject);
+		bool cancel(EventHandle handle);
+		void reserve(size_t events) { this->nodes.reserve(events); }
+
+		uint32_t getToday() const { return this->today; }
+		size_t size() const { return this->scheduled; }
+
+		// moves to the next day and hands every event due on it to the handler
+		template <typename Handler>
+		void advanceDay(Handler&& handler);
+
+		template <typename Handler>
+		void advanceDays(uint32_t days, Handler&& handler) {
+			for (uint32_t i = 0; i < days; i++) {
+				this->advanceDay(handler);
+			}
+		}
+	};
+
+	template <typename Handler>
+	void TimingWheel::advanceDay(Handler&& handler) {
+		this->today++;
+
+		// higher levels first, so their events can fall through to level 0 on the same day
+		for (uint8_t level = levels - 1; level > 0; level--) {
+			if ((this->today & ((1u << (slotBits * level)) - 1)) == 0) {
+				this->cascade(level);
+			}
+		}
+
+		// popping one at a time keeps cancel() valid for events the handler touches
+		Event event;
+		while (this->popDue(event)) {
+			handler(event);
+		}
+	}
+}
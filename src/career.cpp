@@ -0,0 +1,122 @@
+#include "career.h"
+#include "fixtures.h"
+#include "logging.h"
+
+Career::Career::Career(const Setup& setup, Calendar::TimingWheel& calendar) :
+	calendar(calendar), rng(), season(0), scoredBefore({}), order({}), setup(setup), leagues({}), history() {
+	std::seed_seq seq{ (uint32_t)setup.seed, (uint32_t)(setup.seed >> 32) };
+	this->rng.seed(seq);
+
+	std::uniform_real_distribution<float> rating(0.3f, 0.8f);
+	this->leagues.reserve(setup.leagues);
+	for (uint16_t l = 0; l < setup.leagues; l++) {
+		std::vector<Match::TeamSheet> clubs;
+		clubs.reserve(setup.clubsPerLeague);
+		for (uint16_t c = 0; c < setup.clubsPerLeague; c++) {
+			float attack = rating(this->rng);
+			float defence = rating(this->rng);
+			float stamina = rating(this->rng);
+			clubs.emplace_back(attack, defence, stamina);
+		}
+		this->leagues.emplace_back("League " + std::to_string(l + 1), setup.sport, clubs, std::vector<League::Fixture>(), relegationSpots);
+	}
+
+	if (!this->leagues.empty()) {
+		this->startSeason(calendar.getToday() + 1);
+	}
+}
+
+void Career::Career::startSeason(uint32_t startDay) {
+	std::vector<Fixtures::LeagueSpec> specs(this->setup.leagues, Fixtures::LeagueSpec(this->setup.clubsPerLeague, true));
+	Fixtures::SeasonSpec spec;
+	spec.startDay = startDay;
+	spec.daysBetweenRounds = daysBetweenRounds;
+
+	// a new fixture list every season, still fixed by the save seed
+	std::vector<Fixtures::Season> seasons = Fixtures::generateWorld(specs, spec, this->setup.seed + this->season);
+	for (size_t l = 0; l < this->leagues.size(); l++) {
+		League::LeagueState& league = this->leagues[l];
+		league = League::LeagueState(league.name, league.sport, league.getClubs(), seasons[l].fixtures, relegationSpots);
+	}
+
+	// every league shares the same spec, so they share the round days too
+	const std::vector<uint32_t>& days = seasons.front().roundDays;
+	for (uint32_t r = 0; r < days.size(); r++) {
+		this->calendar.schedule(days[r], Calendar::FIXTURE, r);
+	}
+	this->calendar.schedule(days.empty() ? startDay : days.back() + 1, Calendar::SEASON_END, this->season);
+}
+
+bool Career::Career::onEvent(const Calendar::Event& event) {
+	switch (event.type) {
+	case Calendar::FIXTURE:
+		for (size_t i = 0; i < this->leagues.size(); i++) {
+			League::LeagueState& league = this->leagues[i];
+			const size_t firstFixture = league.playedFixtures;
+			this->scoredBefore.clear();
+			for (auto& row : league.table) {
+				this->scoredBefore.push_back(row.scored);
+			}
+			League::playRound(league, this->rng, i == this->setup.userLeague, this->setup.userClub);
+			this->recordRound((uint16_t)i, firstFixture);
+		}
+		return true;
+	case Calendar::SEASON_END:
+		this->archiveSeason();
+		this->season++;
+		this->startSeason(event.day + offSeasonDays);
+		return true;
+	default:
+		return false;
+	}
+}
+
+void Career::Career::recordRound(uint16_t league, size_t firstFixture) {
+	// a club plays once per round, so its score in this round is how much its total grew
+	const League::LeagueState& state = this->leagues[league];
+	World::ResultColumns& results = this->history.results;
+	for (size_t f = firstFixture; f < state.playedFixtures; f++) {
+		const League::Fixture& fixture = state.getFixtures()[f];
+		results.fixtures.push_back(fixture);
+		results.homeScore.push_back((uint16_t)(state.table[fixture.home].scored - this->scoredBefore[fixture.home]));
+		results.awayScore.push_back((uint16_t)(state.table[fixture.away].scored - this->scoredBefore[fixture.away]));
+		results.league.push_back(league);
+		results.season.push_back((uint16_t)this->season);
+	}
+}
+
+void Career::Career::archiveSeason() {
+	World::SeasonColumns& seasons = this->history.seasons;
+	for (size_t l = 0; l < this->leagues.size(); l++) {
+		const League::LeagueState& league = this->leagues[l];
+		league.rankInto(this->order);
+		for (size_t rank = 0; rank < this->order.size(); rank++) {
+			const uint16_t club = this->order[rank];
+			seasons.standings.push_back(league.table[club]);
+			seasons.club.push_back(club);
+			seasons.league.push_back((uint16_t)l);
+			seasons.season.push_back((uint16_t)this->season);
+			seasons.rank.push_back((uint16_t)(rank + 1));
+		}
+	}
+}
+
+uint64_t Career::Career::digest() const {
+	// FNV-1a over every table row
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](uint64_t value) {
+		for (int i = 0; i < 8; i++) {
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 1099511628211ull;
+		}
+	};
+
+	mix(this->season);
+	for (auto& league : this->leagues) {
+		mix(league.playedFixtures);
+		for (auto& row : league.table) {
+			mix(((uint64_t)row.played << 48) | ((uint64_t)row.points << 32) | ((uint64_t)(uint16_t)row.scoreDiff << 16) | row.scored);
+		}
+	}
+	return hash;
+}
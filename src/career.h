@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "league.h"
+#include "calendar.h"
+#include "world.h"
+
+namespace Career {
+	struct Setup {
+		uint64_t seed;
+		Modes::SportModes sport;
+		uint16_t leagues;
+		uint16_t clubsPerLeague;
+		uint16_t userLeague;
+		uint16_t userClub;
+
+		Setup() : seed(0), sport(Modes::HANDBALL), leagues(1), clubsPerLeague(16), userLeague(0), userClub(0) {}
+		Setup(uint64_t s, Modes::SportModes sp, uint16_t l, uint16_t c, uint16_t ul, uint16_t uc) :
+			seed(s), sport(sp), leagues(l), clubsPerLeague(c), userLeague(ul), userClub(uc) {}
+	};
+
+	/*
+	* The part of a career that moves when days pass: the leagues, their rounds on the calendar
+	* and one RNG stream seeded from the save seed. Nothing in here reads the clock, the window
+	* or std::rand, so the same setup and the same sequence of commands always end in the same
+	* world. That's what lets a replay journal re-run a career headless.
+	*/
+	class Career {
+	private:
+		Calendar::TimingWheel& calendar;
+		std::mt19937 rng;
+		uint32_t season;
+		std::vector<uint16_t> scoredBefore;
+		std::vector<uint16_t> order;
+
+		void startSeason(uint32_t startDay);
+		void recordRound(uint16_t league, size_t firstFixture);
+		void archiveSeason();
+	public:
+		static constexpr uint8_t relegationSpots = 2;
+		static constexpr uint8_t daysBetweenRounds = 7;
+		static constexpr uint32_t offSeasonDays = 42;
+
+		Setup setup;
+		std::vector<League::LeagueState> leagues;
+		// every result and final table so far, club indices are per league
+		World::History history;
+
+		Career(const Setup& setup, Calendar::TimingWheel& calendar);
+
+		// plays the career's own events, returns false for anything it doesn't handle
+		bool onEvent(const Calendar::Event& event);
+
+		uint32_t getSeason() const { return this->season; }
+		// hash of every league table, two runs that agree on it played the same matches;
+		// characters aren't part of a career and aren't covered
+		uint64_t digest() const;
+	};
+}
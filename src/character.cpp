@@ -5,13 +5,13 @@
 
 using json = nlohmann::json;
 
-std::string* Names::getRandomName() {
+std::string* Names::getRandomName(std::mt19937& rng) {
 	if (Names::names.size() == 0) {
 		Names::loadRandomNames();
 	}
 
-	std::srand(time(0));
-	int randomNameIndex = std::rand() % Names::names.size();
+	std::uniform_int_distribution<size_t> pick(0, Names::names.size() - 1);
+	size_t randomNameIndex = pick(rng);
 	DEBUG(randomNameIndex);
 	auto res = Names::names[randomNameIndex];
 	Names::names.erase(Names::names.begin() + randomNameIndex);
@@ -198,7 +198,7 @@ void CharacterConfig::Config::PersonaMods::print() {
 }
 
 Character::Character(const std::string& persona, const CharacterConfig::Config& cfg, TraitGenerator* traitGen) {
-	this->name = Names::getRandomName();
+	this->name = Names::getRandomName(traitGen->getRng());
 	this->personality = Traits::stringToPersonalities(persona);
 	this->currentEmotions = std::vector<Traits::CharacterEmotions>();
 	this->motivations = std::vector<Traits::CharacterMotivations>();
@@ -206,7 +206,7 @@ Character::Character(const std::string& persona, const CharacterConfig::Config&
 	this->intelligence = std::vector<Traits::CharacterIntelligence>();
 	this->background = std::vector<Traits::CharacterBackground>();
 
-	auto personality = traitGen->generateCharacterSheet(cfg, persona, time(0));
+	auto personality = traitGen->generateCharacterSheet(cfg, persona, traitGen->getRng()());
 
 	for (auto& element : personality) {
 		if (element.first == "CharacterBackground") {
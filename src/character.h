@@ -124,6 +124,7 @@ public:
 	}
 	std::string pickTraitForCategory(const CharacterConfig::Config& cfg, const std::string& persona, const std::string& category);
 	std::unordered_map<std::string, std::set<std::string>> generateCharacterSheet(const CharacterConfig::Config& cfg, const std::string& persona, unsigned int seed);
+	std::mt19937& getRng() { return rng; }
 
 	
 private:
@@ -163,7 +164,8 @@ namespace Names {
 
 	static std::vector<std::string*> names = {};
 
-	std::string* getRandomName();
+	// drawn from the caller's generator, so a seeded career always names the same people
+	std::string* getRandomName(std::mt19937& rng);
 	void loadRandomNames();
 	void deloadNames();
 }
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "codec.h"
+#include <cstring>
+#include <algorithm>
+
+namespace Codec {
+	static inline uint32_t read32(const uint8_t* p) {
+		uint32_t v;
+		std::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	static inline uint32_t hash(uint32_t sequence) {
+		return (sequence * 2654435761u) >> (32 - hashBits);
+	}
+
+	// length overflow bytes, 255 each until the remainder
+	static inline uint8_t* writeLength(uint8_t* op, size_t length) {
+		while (length >= 255) {
+			*op++ = 255;
+			length -= 255;
+		}
+		*op++ = (uint8_t)length;
+		return op;
+	}
+
+	static inline bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+		uint8_t b;
+		do {
+			if (ip >= end) {
+				return false;
+			}
+			b = *ip++;
+			length += b;
+		} while (b == 255);
+		return true;
+	}
+
+	static uint8_t* writeSequence(uint8_t* op, const uint8_t* opEnd, const uint8_t* literals, size_t literalCount,
+		size_t offset, size_t matchLength) {
+		// worst case for this sequence, checked once up front
+		if ((size_t)(opEnd - op) < 1 + literalCount / 255 + 1 + literalCount + 2 + matchLength / 255 + 1) {
+			return nullptr;
+		}
+
+		uint8_t* token = op++;
+		*token = (uint8_t)(std::min<size_t>(literalCount, 15) << 4);
+		if (literalCount >= 15) {
+			op = writeLength(op, literalCount - 15);
+		}
+		// an empty input has no literals and may come with null pointers
+		if (literalCount) {
+			std::memcpy(op, literals, literalCount);
+		}
+		op += literalCount;
+
+		if (matchLength == 0) {
+			return op;
+		}
+		*op++ = (uint8_t)offset;
+		*op++ = (uint8_t)(offset >> 8);
+		const size_t extra = matchLength - minMatch;
+		*token |= (uint8_t)std::min<size_t>(extra, 15);
+		if (extra >= 15) {
+			op = writeLength(op, extra - 15);
+		}
+		return op;
+	}
+}
+
+size_t Codec::compress(const uint8_t* src, size_t srcBytes, uint8_t* dst, size_t capacity) {
+	uint8_t* op = dst;
+	uint8_t* const opEnd = dst + capacity;
+	const uint8_t* anchor = src;
+	const uint8_t* const end = src + srcBytes;
+
+	if (srcBytes > matchSearchLimit) {
+		const uint8_t* const searchEnd = end - matchSearchLimit;
+		const uint8_t* const matchEnd = end - lastLiterals;
+		uint32_t table[1u << hashBits] = {};
+
+		const uint8_t* ip = src + 1;
+		while (ip < searchEnd) {
+			const uint32_t h = hash(read32(ip));
+			const uint8_t* ref = src + table[h];
+			table[h] = (uint32_t)(ip - src);
+
+			if (ref >= ip || (size_t)(ip - ref) > maxOffset || read32(ref) != read32(ip)) {
+				// step further the longer nothing matched, incompressible data goes by quickly
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+				ip--;
+				ref--;
+			}
+			size_t length = minMatch;
+			while (ip + length < matchEnd && ip[length] == ref[length]) {
+				length++;
+			}
+
+			op = writeSequence(op, opEnd, anchor, (size_t)(ip - anchor), (size_t)(ip - ref), length);
+			if (!op) {
+				return 0;
+			}
+			ip += length;
+			anchor = ip;
+			if (ip - 2 > src && ip < searchEnd) {
+				table[hash(read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+			}
+		}
+	}
+
+	op = writeSequence(op, opEnd, anchor, (size_t)(end - anchor), 0, 0);
+	return op ? (size_t)(op - dst) : 0;
+}
+
+bool Codec::decompress(const uint8_t* src, size_t srcBytes, uint8_t* dst, size_t dstBytes) {
+	const uint8_t* ip = src;
+	const uint8_t* const end = src + srcBytes;
+	uint8_t* op = dst;
+	uint8_t* const opEnd = dst + dstBytes;
+
+	while (ip < end) {
+		const uint8_t token = *ip++;
+
+		size_t literals = token >> 4;
+		if (literals == 15 && !readLength(ip, end, literals)) {
+			return false;
+		}
+		if (literals > (size_t)(end - ip) || literals > (size_t)(opEnd - op)) {
+			return false;
+		}
+		if (literals <= 16 && end - ip >= 16 && opEnd - op >= 16) {
+			// short runs are the common case, one fixed size copy beats a sized memcpy call
+			std::memcpy(op, ip, 16);
+		}
+		else if (literals) {
+			std::memcpy(op, ip, literals);
+		}
+		ip += literals;
+		op += literals;
+
+		if (ip == end) {
+			break;
+		}
+
+		if (end - ip < 2) {
+			return false;
+		}
+		const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst)) {
+			return false;
+		}
+
+		size_t length = token & 15;
+		if (length == 15 && !readLength(ip, end, length)) {
+			return false;
+		}
+		length += minMatch;
+		if (length > (size_t)(opEnd - op)) {
+			return false;
+		}
+
+		const uint8_t* match = op - offset;
+		if (offset >= 8 && (size_t)(opEnd - op) >= length + 8) {
+			// 8 byte steps never read bytes this copy hasn't written yet, the tail past length is overwritten later
+			uint8_t* const stop = op + length;
+			while (op < stop) {
+				std::memcpy(op, match, 8);
+				op += 8;
+				match += 8;
+			}
+			op = stop;
+		}
+		else if (offset >= length) {
+			std::memcpy(op, match, length);
+			op += length;
+		}
+		else {
+			// overlapping copy repeats the last offset bytes, has to go forward one at a time
+			for (size_t i = 0; i < length; i++) {
+				*op++ = *match++;
+			}
+		}
+	}
+	return op == opEnd;
+}
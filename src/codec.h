@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Codec {
+	/*
+	* Byte-oriented LZ77 block codec using the LZ4 block layout: every sequence is a token
+	* (literal length in the high nibble, match length - minMatch in the low one), the
+	* literals, a 16 bit little endian offset and the length overflow bytes. The last
+	* sequence is literals only. Blocks are independent, so they compress and decompress
+	* on any thread in any order.
+	*/
+	constexpr size_t minMatch = 4;
+	constexpr size_t maxOffset = 65535;
+	constexpr size_t lastLiterals = 5;
+	constexpr size_t matchSearchLimit = 12; // no match starts this close to the end of a block
+	constexpr uint32_t hashBits = 12;
+
+	constexpr size_t compressBound(size_t bytes) { return bytes + bytes / 255 + 16; }
+
+	// returns the compressed size, 0 when the output doesn't fit in capacity
+	size_t compress(const uint8_t* src, size_t srcBytes, uint8_t* dst, size_t capacity);
+
+	// true only when the input decodes cleanly into exactly dstBytes, never reads or writes out of bounds
+	bool decompress(const uint8_t* src, size_t srcBytes, uint8_t* dst, size_t dstBytes);
+}
@@ -0,0 +1,120 @@
+#include "crc32c.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CRC32C_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <nmmintrin.h>
+#define CRC32C_TARGET
+#else
+#include <cpuid.h>
+#include <nmmintrin.h>
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+#endif
+
+namespace Crc32c {
+	constexpr uint32_t polynomial = 0x82F63B78u; // reflected Castagnoli
+
+	struct Tables {
+		uint32_t slice[8][256];
+	};
+
+	static constexpr Tables makeTables() {
+		Tables res = {};
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t crc = i;
+			for (int bit = 0; bit < 8; bit++) {
+				crc = (crc >> 1) ^ (polynomial & (0u - (crc & 1)));
+			}
+			res.slice[0][i] = crc;
+		}
+		for (uint32_t i = 0; i < 256; i++) {
+			for (int s = 1; s < 8; s++) {
+				res.slice[s][i] = (res.slice[s - 1][i] >> 8) ^ res.slice[0][res.slice[s - 1][i] & 0xFF];
+			}
+		}
+		return res;
+	}
+
+	static constexpr Tables tables = makeTables();
+
+	static uint32_t software(uint32_t crc, const uint8_t* p, size_t bytes) {
+		while (bytes >= 8) {
+			uint32_t low;
+			uint32_t high;
+			std::memcpy(&low, p, 4);
+			std::memcpy(&high, p + 4, 4);
+			low ^= crc;
+			crc = tables.slice[7][low & 0xFF] ^ tables.slice[6][(low >> 8) & 0xFF]
+				^ tables.slice[5][(low >> 16) & 0xFF] ^ tables.slice[4][low >> 24]
+				^ tables.slice[3][high & 0xFF] ^ tables.slice[2][(high >> 8) & 0xFF]
+				^ tables.slice[1][(high >> 16) & 0xFF] ^ tables.slice[0][high >> 24];
+			p += 8;
+			bytes -= 8;
+		}
+		while (bytes--) {
+			crc = (crc >> 8) ^ tables.slice[0][(crc ^ *p++) & 0xFF];
+		}
+		return crc;
+	}
+
+#ifdef CRC32C_X86
+	CRC32C_TARGET static uint32_t hardware(uint32_t crc, const uint8_t* p, size_t bytes) {
+#if defined(__x86_64__) || defined(_M_X64)
+		uint64_t wide = crc;
+		while (bytes >= 8) {
+			uint64_t word;
+			std::memcpy(&word, p, 8);
+			wide = _mm_crc32_u64(wide, word);
+			p += 8;
+			bytes -= 8;
+		}
+		crc = (uint32_t)wide;
+#endif
+		while (bytes >= 4) {
+			uint32_t word;
+			std::memcpy(&word, p, 4);
+			crc = _mm_crc32_u32(crc, word);
+			p += 4;
+			bytes -= 4;
+		}
+		while (bytes--) {
+			crc = _mm_crc32_u8(crc, *p++);
+		}
+		return crc;
+	}
+
+	static bool detectSse42() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 20)) != 0;
+#else
+		unsigned int eax, ebx, ecx, edx;
+		return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2) != 0;
+#endif
+	}
+#endif
+}
+
+bool Crc32c::hardwareAccelerated() {
+#ifdef CRC32C_X86
+	static const bool available = detectSse42();
+	return available;
+#else
+	return false;
+#endif
+}
+
+uint32_t Crc32c::compute(const void* data, size_t bytes, uint32_t crc) {
+	const uint8_t* p = (const uint8_t*)data;
+	crc = ~crc;
+#ifdef CRC32C_X86
+	if (hardwareAccelerated()) {
+		return ~hardware(crc, p, bytes);
+	}
+#endif
+	return ~software(crc, p, bytes);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Crc32c {
+	/*
+	* CRC-32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the CPU has it and
+	* slicing-by-8 tables otherwise, both give the same result. Passing the previous
+	* result as crc continues a checksum over data fed in pieces.
+	*/
+	uint32_t compute(const void* data, size_t bytes, uint32_t crc = 0);
+
+	bool hardwareAccelerated();
+}
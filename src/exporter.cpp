@@ -0,0 +1,284 @@
+#include "exporter.h"
+#include "career.h"
+#include "logging.h"
+#include "../include/json.hpp"
+#include <fstream>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <filesystem>
+#include <stdexcept>
+#include <type_traits>
+
+using json = nlohmann::json;
+
+namespace Export {
+	template <typename T>
+	constexpr const char* typeName() {
+		if constexpr (std::is_same_v<T, float>) return "float32";
+		else if constexpr (std::is_same_v<T, double>) return "float64";
+		else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, uint8_t>) return "uint8";
+		else if constexpr (std::is_same_v<T, int8_t>) return "int8";
+		else if constexpr (std::is_same_v<T, uint16_t>) return "uint16";
+		else if constexpr (std::is_same_v<T, int16_t>) return "int16";
+		else if constexpr (std::is_same_v<T, uint32_t>) return "uint32";
+		else if constexpr (std::is_same_v<T, int32_t>) return "int32";
+		else if constexpr (std::is_same_v<T, uint64_t>) return "uint64";
+		else {
+			static_assert(std::is_same_v<T, int64_t>, "No schema type for this column.");
+			return "int64";
+		}
+	}
+
+	class Writer {
+	private:
+		std::filesystem::path directory;
+		json& tables;
+		Stats& stats;
+		std::vector<char> staging;
+		size_t used;
+		std::ofstream file;
+		std::string fileName;
+
+		void open(const std::string& name) {
+			this->fileName = name;
+			this->file.open(this->directory / name, std::ios::binary | std::ios::trunc);
+			if (!this->file) {
+				throw std::runtime_error("Could not open " + (this->directory / name).string());
+			}
+			this->used = 0;
+		}
+
+		void flush() {
+			this->file.write(this->staging.data(), this->used);
+			this->stats.bytes += this->used;
+			this->used = 0;
+		}
+
+		void close() {
+			this->flush();
+			this->file.close();
+			if (!this->file) {
+				throw std::runtime_error("Failed to write " + (this->directory / this->fileName).string());
+			}
+			this->stats.files++;
+		}
+
+		// whole chunks are copied as they are, split only where the staging buffer fills up
+		template <typename T>
+		void writeRaw(const World::Column<T>& column) {
+			column.forEachChunk([this](const T* values, size_t count) {
+				const char* bytes = (const char*)values;
+				size_t left = count * sizeof(T);
+				while (left > 0) {
+					size_t take = std::min(left, this->staging.size() - this->used);
+					std::memcpy(this->staging.data() + this->used, bytes, take);
+					this->used += take;
+					bytes += take;
+					left -= take;
+					if (this->used == this->staging.size()) {
+						this->flush();
+					}
+				}
+			});
+		}
+
+		template <typename T, typename Project>
+		void writeProjected(const World::Column<T>& column, Project project) {
+			using V = std::decay_t<decltype(project(std::declval<const T&>()))>;
+			const size_t capacity = this->staging.size() / sizeof(V);
+			column.forEachChunk([&](const T* values, size_t count) {
+				while (count > 0) {
+					if (this->used / sizeof(V) == capacity) {
+						this->flush();
+					}
+					V* out = (V*)this->staging.data() + this->used / sizeof(V);
+					size_t take = std::min(count, capacity - this->used / sizeof(V));
+					for (size_t i = 0; i < take; i++) {
+						out[i] = project(values[i]);
+					}
+					this->used += take * sizeof(V);
+					values += take;
+					count -= take;
+				}
+			});
+		}
+
+	public:
+		Writer(const std::filesystem::path& directory, json& tables, Stats& stats) :
+			directory(directory), tables(tables), stats(stats), staging(writeBytes), used(0), file(), fileName("") {}
+
+		json& table(const std::string& name, size_t rows) {
+			json& res = this->tables[name];
+			res["rows"] = rows;
+			res["columns"] = json::array();
+			return res;
+		}
+
+		template <typename T>
+		json& column(json& table, const std::string& tableName, const std::string& name, const World::Column<T>& column) {
+			const std::string fileName = tableName + "." + name + ".bin";
+			this->open(fileName);
+			this->writeRaw(column);
+			this->close();
+			table["columns"].push_back({ { "name", name }, { "type", typeName<T>() }, { "file", fileName } });
+			return table["columns"].back();
+		}
+
+		// one field of a struct column
+		template <typename T, typename Project>
+		json& field(json& table, const std::string& tableName, const std::string& name, const World::Column<T>& column, Project project) {
+			using V = std::decay_t<decltype(project(std::declval<const T&>()))>;
+			const std::string fileName = tableName + "." + name + ".bin";
+			this->open(fileName);
+			this->writeProjected(column, project);
+			this->close();
+			table["columns"].push_back({ { "name", name }, { "type", typeName<V>() }, { "file", fileName } });
+			return table["columns"].back();
+		}
+
+		json& strings(json& table, const std::string& tableName, const std::string& name, const World::StringColumn& column) {
+			const std::string charsFile = tableName + "." + name + ".chars.bin";
+			const std::string offsetsFile = tableName + "." + name + ".offsets.bin";
+			this->open(charsFile);
+			this->writeRaw(column.chars);
+			this->close();
+			this->open(offsetsFile);
+			this->writeRaw(column.offsets);
+			this->close();
+			table["columns"].push_back({ { "name", name }, { "type", "string" }, { "file", charsFile }, { "offsets", offsetsFile } });
+			return table["columns"].back();
+		}
+	};
+
+	static json traitBits() {
+		auto range = [](uint8_t first, uint8_t count) { return json{ { "firstBit", first }, { "count", count } }; };
+		return {
+			{ "emotions", range(World::emotionBits, (uint8_t)Traits::EMOTION_NONE) },
+			{ "motivations", range(World::motivationBits, (uint8_t)Traits::MOTIVATION_NONE) },
+			{ "moralities", range(World::moralityBits, (uint8_t)Traits::MORALITY_NONE) },
+			{ "intelligence", range(World::intelligenceBits, (uint8_t)Traits::INTELLIGENCE_NONE) },
+			{ "background", range(World::backgroundBits, (uint8_t)Traits::BACKGROUND_NONE) }
+		};
+	}
+
+	template <typename T>
+	static void standingFields(Writer& writer, json& table, const std::string& tableName, const World::Column<T>& column) {
+		writer.field(table, tableName, "played", column, [](const League::Standing& s) { return s.played; });
+		writer.field(table, tableName, "points", column, [](const League::Standing& s) { return s.points; });
+		writer.field(table, tableName, "scoreDiff", column, [](const League::Standing& s) { return s.scoreDiff; });
+		writer.field(table, tableName, "scored", column, [](const League::Standing& s) { return s.scored; });
+	}
+}
+
+Export::Stats Export::exportWorld(const std::string& directory, const World::WorldState& world, const World::History* history) {
+	auto start = std::chrono::steady_clock::now();
+	std::filesystem::create_directories(directory);
+
+	Stats stats;
+	json schema;
+	schema["version"] = schemaVersion;
+	schema["byteOrder"] = "little";
+	schema["tables"] = json::object();
+	Writer writer(directory, schema["tables"], stats);
+
+	const World::CharacterColumns& characters = world.characters;
+	json& c = writer.table("characters", characters.names.size());
+	writer.strings(c, "characters", "name", characters.names);
+	writer.column(c, "characters", "personality", characters.personality)["enum"] = "Traits::CharacterPersonalities";
+	writer.column(c, "characters", "traits", characters.traits)["bits"] = traitBits();
+	writer.column(c, "characters", "club", characters.club);
+
+	const World::ClubColumns& clubs = world.clubs;
+	json& k = writer.table("clubs", clubs.names.size());
+	writer.strings(k, "clubs", "name", clubs.names);
+	writer.field(k, "clubs", "attack", clubs.sheets, [](const Match::TeamSheet& s) { return s.attack; });
+	writer.field(k, "clubs", "defence", clubs.sheets, [](const Match::TeamSheet& s) { return s.defence; });
+	writer.field(k, "clubs", "stamina", clubs.sheets, [](const Match::TeamSheet& s) { return s.stamina; });
+	writer.column(k, "clubs", "league", clubs.league);
+
+	const World::FixtureColumns& fixtures = world.fixtures;
+	json& f = writer.table("fixtures", fixtures.fixtures.size());
+	writer.field(f, "fixtures", "home", fixtures.fixtures, [](const League::Fixture& x) { return x.home; });
+	writer.field(f, "fixtures", "away", fixtures.fixtures, [](const League::Fixture& x) { return x.away; });
+	writer.field(f, "fixtures", "round", fixtures.fixtures, [](const League::Fixture& x) { return x.round; });
+	writer.column(f, "fixtures", "league", fixtures.league);
+	writer.column(f, "fixtures", "day", fixtures.day);
+
+	json& s = writer.table("standings", world.stats.standings.size());
+	standingFields(writer, s, "standings", world.stats.standings);
+
+	if (history) {
+		const World::ResultColumns& results = history->results;
+		json& r = writer.table("results", results.fixtures.size());
+		writer.column(r, "results", "season", results.season);
+		writer.column(r, "results", "league", results.league);
+		writer.field(r, "results", "round", results.fixtures, [](const League::Fixture& x) { return x.round; });
+		writer.field(r, "results", "home", results.fixtures, [](const League::Fixture& x) { return x.home; });
+		writer.field(r, "results", "away", results.fixtures, [](const League::Fixture& x) { return x.away; });
+		writer.column(r, "results", "homeScore", results.homeScore);
+		writer.column(r, "results", "awayScore", results.awayScore);
+
+		const World::SeasonColumns& seasons = history->seasons;
+		json& t = writer.table("seasons", seasons.standings.size());
+		writer.column(t, "seasons", "season", seasons.season);
+		writer.column(t, "seasons", "league", seasons.league);
+		writer.column(t, "seasons", "club", seasons.club);
+		writer.column(t, "seasons", "rank", seasons.rank);
+		standingFields(writer, t, "seasons", seasons.standings);
+	}
+
+	const std::filesystem::path schemaPath = std::filesystem::path(directory) / "schema.json";
+	std::ofstream file(schemaPath, std::ios::trunc);
+	file << schema.dump(1, '\t');
+	file.close();
+	if (!file) {
+		throw std::runtime_error("Failed to write " + schemaPath.string());
+	}
+	stats.files++;
+
+	stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+void Export::Stats::print() const {
+	LOG("Exported " << this->files << " column files, " << this->bytes / (1024 * 1024) << " MB in " << this->ms << " ms ("
+		<< (uint64_t)(this->bytes / (1024.0 * 1024.0) / (this->ms / 1000.0)) << " MB/s)");
+}
+
+void Export::benchmark(uint32_t seasons) {
+	const Career::Setup setup(0xE4, Modes::HANDBALL, 20, 16, 0, 0);
+	Calendar::TimingWheel calendar;
+	Career::Career career(setup, calendar);
+	auto onEvent = [&career](const Calendar::Event& event) { career.onEvent(event); };
+	while (career.getSeason() < seasons) {
+		calendar.advanceDays(7, onEvent);
+	}
+
+	World::WorldState world;
+	for (uint16_t l = 0; l < career.leagues.size(); l++) {
+		const League::LeagueState& league = career.leagues[l];
+		for (size_t c = 0; c < league.clubCount(); c++) {
+			uint32_t id = world.addClub(league.name + " club " + std::to_string(c + 1), league.getClubs()[c], l);
+			world.stats.standings.set(id, league.table[c]);
+		}
+	}
+
+	// the size of the databases users import
+	std::mt19937_64 rng(seasons);
+	const size_t players = 500000;
+	const uint16_t clubCount = (uint16_t)world.clubs.names.size();
+	for (size_t i = 0; i < players; i++) {
+		world.characters.names.add("Player " + std::to_string(i));
+		world.characters.personality.push_back((uint8_t)(rng() % Traits::PERSONALITY_NONE));
+		world.characters.traits.push_back(rng() & ((1ull << World::traitBitCount) - 1));
+		world.characters.club.push_back((uint16_t)(i % clubCount));
+	}
+
+	const std::string directory = "benchmark_export";
+	Stats stats = exportWorld(directory, world, &career.history);
+	LOG(seasons << " seasons: " << career.history.results.fixtures.size() << " results, " << career.history.seasons.standings.size()
+		<< " season rows, " << players << " players");
+	stats.print();
+	std::filesystem::remove_all(directory);
+}
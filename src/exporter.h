@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "world.h"
+
+namespace Export {
+	/*
+	* Writes the world as a directory of typed column files plus a schema.json that lists
+	* every table, its row count and the type and file of each column, for offline analysis
+	* (numpy.fromfile, Arrow, DuckDB). A column file is a raw little-endian array. Strings are
+	* a chars file and a uint32 offsets file with one more entry than there are strings, and
+	* struct columns are split into one file per field. Chunks are copied into a staging buffer
+	* that goes out writeBytes at a time, nothing is formatted per row.
+	*/
+	constexpr size_t writeBytes = 4 << 20;
+	constexpr uint32_t schemaVersion = 1;
+
+	struct Stats {
+		size_t files;
+		uint64_t bytes;
+		double ms;
+
+		Stats() : files(0), bytes(0), ms(0.0) {}
+		void print() const;
+	};
+
+	// history adds the results and season tables, throws when something can't be written
+	Stats exportWorld(const std::string& directory, const World::WorldState& world, const World::History* history = nullptr);
+
+	void benchmark(uint32_t seasons = 10);
+}
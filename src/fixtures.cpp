@@ -0,0 +1,257 @@
+#include "fixtures.h"
+#include "logging.h"
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+std::vector<std::vector<std::pair<uint16_t, uint16_t>>> Fixtures::bergerRounds(uint16_t slots) {
+	const uint16_t rotating = slots - 1;
+	std::vector<std::vector<std::pair<uint16_t, uint16_t>>> rounds(rotating);
+
+	for (uint16_t r = 0; r < rotating; r++) {
+		rounds[r].reserve(slots / 2);
+		if (r % 2 == 0) {
+			rounds[r].push_back({ r, rotating });
+		}
+		else {
+			rounds[r].push_back({ rotating, r });
+		}
+
+		for (uint16_t i = 1; i < slots / 2; i++) {
+			uint16_t a = (r + i) % rotating;
+			uint16_t b = (r + rotating - i) % rotating;
+			if (i % 2 == 1) {
+				rounds[r].push_back({ a, b });
+			}
+			else {
+				rounds[r].push_back({ b, a });
+			}
+		}
+	}
+	return rounds;
+}
+
+namespace Fixtures {
+	static uint16_t countClashes(const std::vector<uint8_t>& home, uint16_t rounds, const std::vector<std::pair<uint16_t, uint16_t>>& sharedStadiums) {
+		uint16_t clashes = 0;
+		for (auto& [a, b] : sharedStadiums) {
+			for (uint16_t r = 0; r < rounds; r++) {
+				clashes += home[a * rounds + r] & home[b * rounds + r];
+			}
+		}
+		return clashes;
+	}
+}
+
+uint16_t Fixtures::repairClashes(std::vector<League::Fixture>& fixtures, uint16_t teams, uint16_t rounds, bool doubleRoundRobin,
+	const std::vector<std::pair<uint16_t, uint16_t>>& sharedStadiums) {
+	if (sharedStadiums.empty()) {
+		return 0;
+	}
+
+	const size_t perHalf = doubleRoundRobin ? fixtures.size() / 2 : fixtures.size();
+
+	// [team * rounds + round] -> 1 when the team is at home
+	std::vector<uint8_t> home(teams * rounds, 0);
+	for (auto& f : fixtures) {
+		home[f.home * rounds + f.round] = 1;
+	}
+
+	auto flip = [&](size_t index) {
+		League::Fixture& f = fixtures[index];
+		home[f.home * rounds + f.round] = 0;
+		home[f.away * rounds + f.round] = 1;
+		std::swap(f.home, f.away);
+	};
+
+	uint16_t clashes = countClashes(home, rounds, sharedStadiums);
+	for (uint8_t pass = 0; pass < 8 && clashes > 0; pass++) {
+		for (size_t i = 0; i < perHalf && clashes > 0; i++) {
+			const League::Fixture& f = fixtures[i];
+			bool involved = false;
+			for (auto& [a, b] : sharedStadiums) {
+				if ((f.home == a && home[b * rounds + f.round]) || (f.home == b && home[a * rounds + f.round])) {
+					involved = true;
+					break;
+				}
+			}
+			if (!involved) {
+				continue;
+			}
+
+			// the return leg is flipped too so every pairing keeps one home game each
+			flip(i);
+			if (doubleRoundRobin) {
+				flip(i + perHalf);
+			}
+			uint16_t after = countClashes(home, rounds, sharedStadiums);
+			if (after < clashes) {
+				clashes = after;
+			}
+			else {
+				flip(i);
+				if (doubleRoundRobin) {
+					flip(i + perHalf);
+				}
+			}
+		}
+	}
+	return clashes;
+}
+
+std::vector<uint32_t> Fixtures::roundDays(uint16_t rounds, const SeasonSpec& spec) {
+	std::vector<uint32_t> days;
+	days.reserve(rounds);
+
+	uint32_t day = spec.startDay;
+	for (uint16_t r = 0; r < rounds; r++) {
+		bool moved = true;
+		while (moved) {
+			moved = false;
+			for (auto& [first, last] : spec.internationalBreaks) {
+				if (day >= first && day <= last) {
+					day = last + 1;
+					moved = true;
+				}
+			}
+		}
+		days.push_back(day);
+		day += spec.daysBetweenRounds;
+	}
+	return days;
+}
+
+Fixtures::Season Fixtures::generate(const LeagueSpec& league, const SeasonSpec& season, uint64_t saveSeed, uint32_t leagueIndex) {
+	Season res;
+	if (league.teams < 2) {
+		ERROR("A league needs at least two teams.");
+		return res;
+	}
+
+	std::seed_seq seed{ (uint32_t)saveSeed, (uint32_t)(saveSeed >> 32), leagueIndex };
+	std::mt19937 rng(seed);
+
+	const bool bye = league.teams % 2 == 1;
+	const uint16_t slots = league.teams + (bye ? 1 : 0);
+	const uint16_t byeSlot = slots - 1;
+
+	// complementary slot pairs, see bergerRounds
+	std::vector<std::pair<uint16_t, uint16_t>> slotPairs;
+	if (!bye) {
+		slotPairs.push_back({ 0, (uint16_t)(slots - 1) });
+	}
+	for (uint16_t s = 1; s + 1 <= slots - 2; s += 2) {
+		slotPairs.push_back({ s, (uint16_t)(s + 1) });
+	}
+	std::shuffle(slotPairs.begin(), slotPairs.end(), rng);
+
+	std::vector<std::pair<uint16_t, uint16_t>> sharedStadiums;
+	for (auto& [a, b] : league.sharedStadiums) {
+		if (a < league.teams && b < league.teams && a != b) {
+			sharedStadiums.push_back({ a, b });
+		}
+		else {
+			ERROR("Invalid shared stadium pair " << a << " " << b);
+		}
+	}
+
+	// slot -> team, partners first so they land on opposite patterns
+	std::vector<int32_t> slotTeam(slots, -1);
+	std::vector<uint8_t> placed(league.teams, 0);
+	size_t nextPair = 0;
+	for (auto& [a, b] : sharedStadiums) {
+		if (placed[a] || placed[b] || nextPair >= slotPairs.size()) {
+			continue;
+		}
+		auto [sa, sb] = slotPairs[nextPair++];
+		if (rng() & 1) {
+			std::swap(sa, sb);
+		}
+		slotTeam[sa] = a;
+		slotTeam[sb] = b;
+		placed[a] = placed[b] = 1;
+	}
+
+	std::vector<uint16_t> rest;
+	for (uint16_t t = 0; t < league.teams; t++) {
+		if (!placed[t]) {
+			rest.push_back(t);
+		}
+	}
+	std::shuffle(rest.begin(), rest.end(), rng);
+	size_t nextTeam = 0;
+	for (uint16_t s = 0; s < slots; s++) {
+		if (slotTeam[s] == -1 && !(bye && s == byeSlot)) {
+			slotTeam[s] = rest[nextTeam++];
+		}
+	}
+
+	auto rounds = bergerRounds(slots);
+	const uint16_t half = (uint16_t)rounds.size();
+	const uint16_t totalRounds = league.doubleRoundRobin ? half * 2 : half;
+	const size_t perRound = league.teams / 2;
+	res.fixtures.reserve(perRound * totalRounds);
+
+	for (uint16_t r = 0; r < half; r++) {
+		for (auto& [h, a] : rounds[r]) {
+			if (slotTeam[h] == -1 || slotTeam[a] == -1) {
+				continue;
+			}
+			res.fixtures.emplace_back((uint16_t)slotTeam[h], (uint16_t)slotTeam[a], r);
+		}
+	}
+	if (league.doubleRoundRobin) {
+		const size_t firstHalf = res.fixtures.size();
+		for (size_t i = 0; i < firstHalf; i++) {
+			const League::Fixture& f = res.fixtures[i];
+			res.fixtures.emplace_back(f.away, f.home, (uint16_t)(f.round + half));
+		}
+	}
+
+	res.unresolvedClashes = repairClashes(res.fixtures, league.teams, totalRounds, league.doubleRoundRobin, sharedStadiums);
+	res.roundDays = roundDays(totalRounds, season);
+	return res;
+}
+
+std::vector<Fixtures::Season> Fixtures::generateWorld(const std::vector<LeagueSpec>& leagues, const SeasonSpec& season, uint64_t saveSeed) {
+	std::vector<Season> res;
+	res.reserve(leagues.size());
+	for (uint32_t i = 0; i < leagues.size(); i++) {
+		res.push_back(generate(leagues[i], season, saveSeed, i));
+		if (res.back().unresolvedClashes > 0) {
+			DEBUG("League " << i << " has " << res.back().unresolvedClashes << " shared stadium clashes left.");
+		}
+	}
+	return res;
+}
+
+void Fixtures::scheduleSeason(Calendar::TimingWheel& calendar, const Season& season, uint32_t firstFixtureId) {
+	for (size_t i = 0; i < season.fixtures.size(); i++) {
+		calendar.schedule(season.roundDays[season.fixtures[i].round], Calendar::FIXTURE, firstFixtureId + (uint32_t)i);
+	}
+}
+
+void Fixtures::benchmark(uint16_t leagues, uint16_t teams) {
+	std::vector<LeagueSpec> specs;
+	specs.reserve(leagues);
+	for (uint16_t i = 0; i < leagues; i++) {
+		// odd team counts and shared stadiums in a few leagues to exercise byes and the repair pass
+		uint16_t count = teams + (i % 3 == 0 ? 1 : 0);
+		specs.emplace_back(count, true, std::vector<std::pair<uint16_t, uint16_t>>{ { 0, 1 }, { 2, 3 }, { 4, 5 } });
+	}
+
+	SeasonSpec season;
+	season.internationalBreaks = { { 60, 70 }, { 120, 130 }, { 200, 210 } };
+
+	auto start = std::chrono::steady_clock::now();
+	auto world = generateWorld(specs, season, 0x5EED);
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+	size_t fixtures = 0;
+	size_t clashes = 0;
+	for (auto& s : world) {
+		fixtures += s.fixtures.size();
+		clashes += s.unresolvedClashes;
+	}
+	LOG("Generated " << fixtures << " fixtures for " << leagues << " leagues in " << elapsed.count() / 1000.0 << " ms, " << clashes << " clashes left");
+}
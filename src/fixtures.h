@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "league.h"
+#include "calendar.h"
+
+namespace Fixtures {
+	struct LeagueSpec {
+		uint16_t teams;
+		bool doubleRoundRobin;
+		std::vector<std::pair<uint16_t, uint16_t>> sharedStadiums;
+
+		LeagueSpec() : teams(0), doubleRoundRobin(true), sharedStadiums({}) {}
+		LeagueSpec(uint16_t t, bool d, std::vector<std::pair<uint16_t, uint16_t>> s = {}) : teams(t), doubleRoundRobin(d), sharedStadiums(s) {}
+	};
+
+	struct SeasonSpec {
+		uint32_t startDay;
+		uint8_t daysBetweenRounds;
+		std::vector<std::pair<uint32_t, uint32_t>> internationalBreaks; // first and last day without league fixtures
+
+		SeasonSpec() : startDay(0), daysBetweenRounds(7), internationalBreaks({}) {}
+	};
+
+	struct Season {
+		std::vector<League::Fixture> fixtures; // ordered by round
+		std::vector<uint32_t> roundDays;
+		uint16_t unresolvedClashes;
+
+		Season() : fixtures({}), roundDays({}), unresolvedClashes(0) {}
+	};
+
+	/*
+	* Single round robin over slots with the circle method. The fixed slot alternates home and
+	* away and the rotating pairs are oriented by their distance, which gives the minimum of
+	* n - 2 breaks. Slots 2k + 1 and 2k + 2 (and 0 with n - 1) get exactly opposite home/away
+	* patterns, which is where shared-stadium partners are placed.
+	*/
+	std::vector<std::vector<std::pair<uint16_t, uint16_t>>> bergerRounds(uint16_t slots);
+
+	// flips fixtures (together with their return leg) until no two partners are home in the same round
+	uint16_t repairClashes(std::vector<League::Fixture>& fixtures, uint16_t teams, uint16_t rounds, bool doubleRoundRobin,
+		const std::vector<std::pair<uint16_t, uint16_t>>& sharedStadiums);
+
+	std::vector<uint32_t> roundDays(uint16_t rounds, const SeasonSpec& spec);
+
+	// the same save seed and league index always give the same season
+	Season generate(const LeagueSpec& league, const SeasonSpec& season, uint64_t saveSeed, uint32_t leagueIndex);
+	std::vector<Season> generateWorld(const std::vector<LeagueSpec>& leagues, const SeasonSpec& season, uint64_t saveSeed);
+
+	// one FIXTURE event per match, the subject is firstFixtureId + the fixture's index
+	void scheduleSeason(Calendar::TimingWheel& calendar, const Season& season, uint32_t firstFixtureId);
+
+	void benchmark(uint16_t leagues = 100, uint16_t teams = 20);
+}
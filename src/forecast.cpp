@@ -0,0 +1,87 @@
+#include "forecast.h"
+#include "logging.h"
+
+Forecast::SeasonForecaster::SeasonForecaster(const League::LeagueState& state, uint64_t seed) :
+	base(state.fork()), seed(seed), clubs(state.clubCount()), completedRuns(0), activeBatches(0), cancelled(false) {
+	this->histogram = std::make_unique<std::atomic<uint32_t>[]>(this->clubs * this->clubs);
+	for (size_t i = 0; i < this->clubs * this->clubs; i++) {
+		this->histogram[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+Forecast::SeasonForecaster::~SeasonForecaster() {
+	this->cancel();
+	this->wait();
+}
+
+void Forecast::SeasonForecaster::start(uint32_t runs, Jobs::ThreadPool* pool) {
+	switch (this->base.sport) {
+	case Modes::HANDBALL:
+		this->start<Match::RulesFor<Modes::HANDBALL>::type>(runs, pool);
+		break;
+	default:
+		ERROR("No match engine for the league's sport.");
+		break;
+	}
+}
+
+void Forecast::SeasonForecaster::mergeBatch(const std::vector<uint32_t>& local, uint32_t runs) {
+	for (size_t i = 0; i < local.size(); i++) {
+		if (local[i]) {
+			this->histogram[i].fetch_add(local[i], std::memory_order_relaxed);
+		}
+	}
+	this->completedRuns.fetch_add(runs, std::memory_order_release);
+
+	std::lock_guard<std::mutex> guard(this->batchLock);
+	if (this->activeBatches.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		this->batchesDone.notify_all();
+	}
+}
+
+void Forecast::SeasonForecaster::wait() const {
+	std::unique_lock<std::mutex> guard(this->batchLock);
+	this->batchesDone.wait(guard, [this]() { return this->activeBatches.load(std::memory_order_acquire) == 0; });
+}
+
+void Forecast::SeasonForecaster::cancel() {
+	this->cancelled.store(true, std::memory_order_relaxed);
+}
+
+Forecast::Snapshot Forecast::SeasonForecaster::snapshot() const {
+	Snapshot res;
+	res.runs = this->getCompletedRuns();
+	res.positionOdds = std::vector<std::vector<float>>(this->clubs, std::vector<float>(this->clubs, 0.f));
+	res.titleOdds = std::vector<float>(this->clubs, 0.f);
+	res.relegationOdds = std::vector<float>(this->clubs, 0.f);
+
+	for (size_t club = 0; club < this->clubs; club++) {
+		// a batch may be halfway through merging, so normalize each row by its own total
+		uint64_t total = 0;
+		for (size_t pos = 0; pos < this->clubs; pos++) {
+			uint32_t count = this->histogram[club * this->clubs + pos].load(std::memory_order_relaxed);
+			res.positionOdds[club][pos] = (float)count;
+			total += count;
+		}
+		if (total == 0) {
+			continue;
+		}
+
+		for (size_t pos = 0; pos < this->clubs; pos++) {
+			res.positionOdds[club][pos] /= (float)total;
+			if (pos + this->base.relegationSpots >= this->clubs) {
+				res.relegationOdds[club] += res.positionOdds[club][pos];
+			}
+		}
+		res.titleOdds[club] = res.positionOdds[club][0];
+	}
+	return res;
+}
+
+void Forecast::Snapshot::print(const std::vector<std::string>& clubNames) const {
+	DEBUG("Forecast after " << this->runs << " runs:");
+	for (size_t club = 0; club < this->titleOdds.size(); club++) {
+		std::string name = club < clubNames.size() ? clubNames[club] : "Club " + std::to_string(club);
+		DEBUG("\t" << name << " title: " << this->titleOdds[club] * 100.f << "% relegation: " << this->relegationOdds[club] * 100.f << "%");
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "league.h"
+#include "thread_pool.h"
+#include "handball_rules.h"
+
+namespace Forecast {
+	struct Snapshot {
+		uint32_t runs;
+		std::vector<std::vector<float>> positionOdds; // [club][final position]
+		std::vector<float> titleOdds;
+		std::vector<float> relegationOdds;
+
+		Snapshot() : runs(0) {}
+		void print(const std::vector<std::string>& clubNames = {}) const;
+	};
+
+	/*
+	* Simulates the rest of a season many times on the job pool. Each batch forks the
+	* league (only the table is copied), draws from its own RNG stream and adds its
+	* local position counts to the shared histogram with relaxed atomic adds, so
+	* snapshot() can be read at any time while batches are still running.
+	*/
+	class SeasonForecaster {
+	private:
+		League::LeagueState base;
+		uint64_t seed;
+		size_t clubs;
+		std::unique_ptr<std::atomic<uint32_t>[]> histogram;
+		std::atomic<uint32_t> completedRuns;
+		std::atomic<uint32_t> activeBatches;
+		std::atomic<bool> cancelled;
+		// the last batch signals under this, so wait() can't return while it still touches the forecaster
+		mutable std::mutex batchLock;
+		mutable std::condition_variable batchesDone;
+
+		template <typename Rules>
+		void runBatch(uint32_t batch, uint32_t runs);
+		void mergeBatch(const std::vector<uint32_t>& local, uint32_t runs);
+
+		SeasonForecaster(const SeasonForecaster&) = delete;
+		SeasonForecaster& operator=(const SeasonForecaster&) = delete;
+	public:
+		static constexpr uint32_t runsPerBatch = 256;
+
+		SeasonForecaster(const League::LeagueState& state, uint64_t seed);
+		~SeasonForecaster();
+
+		template <typename Rules>
+		void start(uint32_t runs, Jobs::ThreadPool* pool = Jobs::ThreadPool::getPool());
+		void start(uint32_t runs, Jobs::ThreadPool* pool = Jobs::ThreadPool::getPool());
+
+		Snapshot snapshot() const;
+		uint32_t getCompletedRuns() const { return this->completedRuns.load(std::memory_order_acquire); }
+		bool finished() const { return this->activeBatches.load(std::memory_order_acquire) == 0; }
+		void wait() const;
+		void cancel();
+	};
+
+	template <typename Rules>
+	void SeasonForecaster::runBatch(uint32_t batch, uint32_t runs) {
+		std::seed_seq streamSeed{ (uint32_t)this->seed, (uint32_t)(this->seed >> 32), batch };
+		std::mt19937 rng(streamSeed);
+
+		std::vector<uint32_t> local(this->clubs * this->clubs, 0);
+		std::vector<uint16_t> order;
+
+		uint32_t done = 0;
+		for (; done < runs && !this->cancelled.load(std::memory_order_relaxed); done++) {
+			League::LeagueState run = this->base.fork();
+			while (League::playNextFixture<Rules>(run, rng, Match::STATISTICAL)) {}
+
+			run.rankInto(order);
+			for (size_t pos = 0; pos < order.size(); pos++) {
+				local[order[pos] * this->clubs + pos]++;
+			}
+		}
+		this->mergeBatch(local, done);
+	}
+
+	template <typename Rules>
+	void SeasonForecaster::start(uint32_t runs, Jobs::ThreadPool* pool) {
+		uint32_t batches = (runs + runsPerBatch - 1) / runsPerBatch;
+		this->activeBatches.fetch_add(batches, std::memory_order_acq_rel);
+
+		for (uint32_t b = 0; b < batches; b++) {
+			uint32_t batchRuns = std::min(runsPerBatch, runs - b * runsPerBatch);
+			pool->submit([this, b, batchRuns]() { this->runBatch<Rules>(b, batchRuns); });
+		}
+	}
+}
@@ -1,40 +1,52 @@
 #include "game.h"
+#include "thread_pool.h"
 
 Game::Game::Game() {
 	//this->saves = std::vector<SaveCreator::Save*>();
+	this->currentSave = nullptr;
+	this->thumbnailTaken = false;
+	this->career = nullptr;
+	this->assets = Assets::Loader::getLoader();
+	this->saveIndex.scan(savesDirectory);
 	this->renderer = Graphics::Renderer::getRender();
 
-	LOG("Loading textures...");
-	Graphics::loadTextures();
-	LOG("Finished loading.");
-
-	LOG("Loading names...");
-	Names::loadRandomNames();
-	LOG("Finished loading");
-
-	this->characterConfig = CharacterConfig::loadConfig("res\\traits.json");
+	// nothing below waits for these, the menus show placeholders until they arrive
+	Assets::requestMainFont();
+	Assets::requestTextures();
+	this->assets->request(namesAsset, []() -> Assets::Loader::Step {
+		Names::loadRandomNames();
+		return []() { return true; };
+	});
+	this->assets->request(traitsAsset, [this]() -> Assets::Loader::Step {
+		auto config = std::make_shared<CharacterConfig::Config>(CharacterConfig::loadConfig("res\\traits.json"));
+		return [this, config]() { this->characterConfig = std::move(*config); return true; };
+	});
 	this->traitGenerator = TraitGenerator((unsigned)time(0));
+	// the cheaper match tiers sample this table, building it here keeps the first simulated week from stalling
+	Jobs::ThreadPool::getPool()->submit([]() {
+		League::prepare(Modes::HANDBALL);
+	});
 
 	this->renderer->createLayer(mainMenuLayerName, false, 1);
 	this->renderer->createLayer(savesMenuLayerName, false, 1);
 	this->renderer->createLayer(newGameMenuLayerName, false, 2);
 
-	Graphics::BackgroundBuilder builder = Graphics::BackgroundBuilder();
+	Graphics::BackgroundBuilder builder = Graphics::BackgroundBuilder(this->renderer->getLayer(mainMenuLayerName)->arena);
 	builder.withTexture(TextureNames::mainBG)
 		.withLayer(this->renderer->getLayer(mainMenuLayerName))
 		.withName("mainBG")
 		.withZIndex(1);
 	this->mainMenuBG = builder.build();
 
-	//this->initMainMenu();
-	//this->initNewGameMenu();
+	this->initMainMenu();
+	this->initNewGameMenu();
 	//this->initSavesMenu();
 	
 	this->renderer->revealLayer(mainMenuLayerName);
 }
 
 void Game::Game::initMainMenu() {
-	Graphics::ButtonBuilder newGameBuilderButton = Graphics::ButtonBuilder();
+	Graphics::ButtonBuilder newGameBuilderButton = Graphics::ButtonBuilder(this->renderer->getLayer(mainMenuLayerName)->arena);
 	newGameBuilderButton.withName("New Game")
 		.withTexture(TextureNames::button)
 		.withLayer(this->renderer->getLayer(mainMenuLayerName))
@@ -54,7 +66,93 @@ void Game::Game::initSavesMenu() {
 		2, this->renderer->getLayer(savesMenuLayerName));
 	*/
 	
-	this->renderer->getLayer(savesMenuLayerName)->addObject(this->mainMenuBG);
+	auto start = std::chrono::steady_clock::now();
+	// the slot list is rebuilt from scratch every time, clearing frees the previous one
+	this->renderer->clearLayer(savesMenuLayerName);
+	Graphics::Layer* layer = this->renderer->getLayer(savesMenuLayerName);
+	layer->addObject(this->mainMenuBG);
+
+	// the index is built in the background since startup, this only waits if it hasn't finished yet
+	this->saveIndex.wait();
+	float offset = 0;
+	for (auto& slot : this->saveIndex.getSlots()) {
+		const std::string path = slot.path;
+		Graphics::ButtonBuilder slotBuilderButton = Graphics::ButtonBuilder(layer->arena);
+		slotBuilderButton.withText(slot.describe())
+			.withTextPos(LayoutDesign::center_x, LayoutDesign::header_y)
+			.withTextPosOffest(0, offset);
+		slotBuilderButton.withName(path)
+			.withTexture(TextureNames::button)
+			.withLayer(layer)
+			.withHandler([this, path]() { this->loadSave(path); })
+			.withZIndex(2)
+			.withTexturePos(LayoutDesign::center_x, LayoutDesign::header_y)
+			.withTexturePosOffset(0, offset)
+			.withTextureScale(LayoutDesign::global_scaleX, LayoutDesign::global_scaleY);
+		slotBuilderButton.build();
+
+		if (slot.thumbnail) {
+			Graphics::TextureHandle thumbnail = Graphics::addImageTexture("thumbnail:" + path, *slot.thumbnail);
+			Graphics::BackgroundBuilder thumbnailBuilder = Graphics::BackgroundBuilder(layer->arena);
+			thumbnailBuilder.withTexture(thumbnail)
+				.withLayer(layer)
+				.withName(path + " thumbnail")
+				.withZIndex(2)
+				.withTexturePos(LayoutDesign::thumbnail_x, LayoutDesign::header_y)
+				.withTexturePosOffset(0, offset);
+			thumbnailBuilder.build();
+			// the builder holds it from here, clearing the menu frees it
+			Graphics::textures.unload(thumbnail);
+		}
+		offset += LayoutDesign::slot_spacing;
+	}
+	DEBUG("Saves menu built with " << layer->arena.getAllocations() << " allocations (" << layer->arena.getBytes() << " bytes).");
+	// index wait, slot widgets and thumbnail uploads, meant to stay under 50 ms
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LOG("Saves menu with " << this->saveIndex.getSlots().size() << " slots opened in " << ms << " ms");
+}
+
+void Game::Game::startCareer(const Career::Setup& setup) {
+	try {
+		this->assets->require(namesAsset);
+		this->assets->require(traitsAsset);
+	}
+	catch (std::exception& e) {
+		// the leagues don't need them, only generated characters do
+		ERROR(e.what());
+	}
+	delete this->career;
+	this->calendar = Calendar::TimingWheel();
+	// everything random in a career comes from its seed, so the journal below can replay it
+	this->traitGenerator = TraitGenerator((unsigned)(setup.seed ^ (setup.seed >> 32)));
+	this->career = new Career::Career(setup, this->calendar);
+
+	std::filesystem::create_directories(replaysDirectory);
+	this->journal.begin(std::string(replaysDirectory) + "/career_" + std::to_string(setup.seed) + ".journal", setup);
+	Replay::setRecorder(&this->journal);
+}
+
+void Game::Game::loadSave(const std::string& path) {
+	try {
+		std::shared_ptr<SaveCreator::Save> save(SaveCreator::Save::load(path));
+		// the new save's chunks start over at low generations, the marks of the old one would skip edits
+		this->autosaver.reset();
+		this->currentSave = save;
+		this->thumbnailTaken = false;
+		this->calendar = Calendar::TimingWheel(save->day);
+		this->playClock.restart();
+		// the checksums are computed on a snapshot off the main thread, check() in continueDays then
+		// only has to swap out what this found
+		SaveCreator::Save* snapshot = save->snapshot();
+		Jobs::ThreadPool::getPool()->submit([snapshot]() {
+			snapshot->world.verify();
+			delete snapshot;
+		});
+		LOG("Loaded " << save->name << " (" << save->world.characters.personality.size() << " characters)");
+	}
+	catch (std::exception& e) {
+		ERROR("Failed to load " << path << ". " << e.what());
+	}
 }
 
 void Game::Game::initNewGameMenu() {
@@ -73,32 +171,174 @@ void Game::Game::initNewGameMenu() {
 		2, this->renderer->getLayer(newGameMenuLayerName));
 	*/
 
-	this->renderer->getLayer(newGameMenuLayerName)->addObject(this->mainMenuBG);
+	Graphics::Layer* layer = this->renderer->getLayer(newGameMenuLayerName);
+	layer->addObject(this->mainMenuBG);
+
+	// every career gets a fresh seed, the journal startCareer opens is what replays it
+	Graphics::ButtonBuilder startBuilderButton = Graphics::ButtonBuilder(layer->arena);
+	startBuilderButton.withText("Start career")
+		.withTextPos(LayoutDesign::center_x, LayoutDesign::center_y);
+	startBuilderButton.withName("Start_Career")
+		.withTexture(TextureNames::button)
+		.withLayer(layer)
+		.withHandler([this]() {
+			std::random_device device;
+			const uint64_t seed = ((uint64_t)device() << 32) | device();
+			this->startCareer(Career::Setup(seed, Modes::HANDBALL, 1, 16, 0, 0));
+		})
+		.withZIndex(2)
+		.withTexturePos(LayoutDesign::center_x, LayoutDesign::center_y)
+		.withTextureOrigin(2.f, 2.f)
+		.withTextureScale(LayoutDesign::global_scaleX, LayoutDesign::global_scaleY);
+	startBuilderButton.build();
+
+	Graphics::ButtonBuilder continueBuilderButton = Graphics::ButtonBuilder(layer->arena);
+	continueBuilderButton.withText("Continue")
+		.withTextPos(LayoutDesign::center_x, LayoutDesign::center_y)
+		.withTextPosOffest(0, LayoutDesign::slot_spacing);
+	continueBuilderButton.withName("Continue")
+		.withTexture(TextureNames::button)
+		.withLayer(layer)
+		.withHandler([this]() {
+			if (this->career) {
+				this->continueDays(Career::Career::daysBetweenRounds);
+			}
+		})
+		.withZIndex(2)
+		.withTexturePos(LayoutDesign::center_x, LayoutDesign::center_y)
+		.withTextureOrigin(2.f, 2.f)
+		.withTexturePosOffset(0, LayoutDesign::slot_spacing)
+		.withTextureScale(LayoutDesign::global_scaleX, LayoutDesign::global_scaleY);
+	continueBuilderButton.build();
+}
+
+void Game::Game::continueDays(uint32_t days) {
+	if (this->currentSave && !this->currentSave->world.check()) {
+		ERROR(this->currentSave->name << " has corrupt chunks, what they held was reset.");
+	}
+	auto start = std::chrono::steady_clock::now();
+	// handlers may schedule more events than fire, so the calendar's size can't tell
+	size_t fired = 0;
+
+	this->calendar.advanceDays(days, [this, &fired](const Calendar::Event& event) {
+		fired++;
+		this->onCalendarEvent(event);
+	});
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	LOG("Advanced to " << Calendar::dayToDate(this->calendar.getToday()).toString() << ", " << fired 
+		<< " events in " << elapsed.count() << " ms");
+
+	if (this->journal.isRecording()) {
+		this->journal.record(Replay::Entry(Replay::ADVANCE_DAYS, this->calendar.getToday(), days,
+			this->career ? this->career->digest() : 0, "", ""));
+	}
+
+	if (this->currentSave && !this->currentSave->path.empty()) {
+		this->currentSave->day = this->calendar.getToday();
+		this->currentSave->playSeconds += (uint64_t)this->playClock.restart().asSeconds();
+		// the first autosave of a session refreshes the thumbnail, later ones only every thumbnailInterval
+		if (this->autosaver.autosave(*this->currentSave, this->currentSave->path)
+			&& (!this->thumbnailTaken || this->thumbnailClock.getElapsedTime() >= thumbnailInterval)) {
+			this->captureThumbnail(this->currentSave->path);
+		}
+	}
+}
+
+void Game::Game::captureThumbnail(const std::string& savePath) {
+	if (!this->renderer->window.isOpen()) {
+		return;
+	}
+	// only the read back happens here, scaling and encoding run on the pool
+	auto start = std::chrono::steady_clock::now();
+	sf::Texture capture;
+	if (!capture.resize(this->renderer->window.getSize())) {
+		return;
+	}
+	capture.update(this->renderer->window);
+	auto frame = std::make_shared<sf::Image>(capture.copyToImage());
+	this->thumbnailTaken = true;
+	this->thumbnailClock.restart();
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LOG("Thumbnail read back in " << ms << " ms");
+	Jobs::ThreadPool::getPool()->submit([frame, savePath]() {
+		try {
+			SaveCreator::writeThumbnail(savePath, *frame);
+		}
+		catch (std::exception& e) {
+			ERROR("Couldn't write the save thumbnail. " << e.what());
+		}
+	});
+}
+
+void Game::Game::onCalendarEvent(const Calendar::Event& event) {
+	if (this->career && this->career->onEvent(event)) {
+		return;
+	}
+	if (this->calendarHandlers[event.type]) {
+		this->calendarHandlers[event.type](event);
+	}
 }
 
 void Game::Game::run() {
+	sf::Clock frameClock;
 	while (this->renderer->window.isOpen()) {
-		while (std::optional event = this->renderer->window.pollEvent()) {
+		// sleeps in the OS until something happens when there's nothing left to draw
+		if (this->assets->pump(assetUploadBudget)) {
+			this->renderer->requestRedraw();
+		}
+		std::optional<sf::Event> event = this->renderer->needsFrame()
+			? this->renderer->window.pollEvent()
+			: this->renderer->window.waitEvent(this->assets->idle() ? idleWakeup : assetPollInterval);
+
+		// everything that queued up since the last frame is handled before drawing once,
+		// of a run of mouse moves only the last one matters
+		std::optional<sf::Event> pendingMove;
+		for (; event; event = this->renderer->window.pollEvent()) {
 			if (event->is<sf::Event::Closed>()) {
 				this->shutdown();
 				return;
 			}
-			
-			this->renderer->handleHover(event);
+			if (event->is<sf::Event::MouseMoved>()) {
+				pendingMove = event;
+				continue;
+			}
+			if (pendingMove) {
+				this->renderer->handleHover(pendingMove);
+				pendingMove.reset();
+			}
+			if (event->is<sf::Event::Resized>() || event->is<sf::Event::FocusGained>()) {
+				this->renderer->requestRedraw();
+			}
+
 			this->renderer->handleClick(event);
 			this->renderer->handleKeyPress(event);
+			this->renderer->handleScroll(event);
+		}
+		if (pendingMove) {
+			this->renderer->handleHover(pendingMove);
+		}
 
-			this->renderer->refreshFrame();
+		if (this->renderer->refreshFrame()) {
+			this->assets->frameShown();
+			// vsync normally does the pacing, this only matters where the driver ignores it
+			const sf::Time elapsed = frameClock.restart();
+			if (elapsed < minFrameTime) {
+				sf::sleep(minFrameTime - elapsed);
+				frameClock.restart();
+			}
 		}
 	}
 }
 
 void Game::Game::shutdown() {
+	this->autosaver.wait();
+	Replay::setRecorder(nullptr);
+	this->journal.close();
+	delete this->career;
 	this->renderer->window.close();
 	Graphics::deloadTextures();
 	Graphics::deloadFont();
-	delete this->mainMenuBG;
-	delete this->onScreenBG;
 	exit(0);
 }
 
@@ -120,10 +360,18 @@ Graphics::Layer* Graphics::Renderer::getLayer(const std::string& name) {
 }
 
 
-void Graphics::Renderer::deleteVector(const std::map<uint8_t, std::vector<Graphics::Object*>>& vector) {
-	for (auto& layer : vector) {
-		for (auto element : layer.second) {
-			delete element;
-		}
+void Graphics::Renderer::clearLayer(const std::string& name) {
+	Layer* layer = this->getLayer(name);
+	if (!layer) {
+		return;
 	}
+	// whatever was hovered or focused may be on it, none of it outlives the clear
+	this->currentTargetObject = nullptr;
+	this->prevTargetObject = nullptr;
+	this->currentClickedObject = nullptr;
+	this->prevClickedObject = nullptr;
+	this->inputBoxActive = false;
+	this->stopAnimating(layer);
+	layer->clear();
+	this->requestRedraw();
 }
@@ -7,13 +7,26 @@ namespace Game {
 	public:
 		CharacterConfig::Config characterConfig;
 		TraitGenerator traitGenerator;
+		Calendar::TimingWheel calendar;
+		Career::Career* career;
+		Replay::Journal journal;
+		std::array<std::function<void(const Calendar::Event&)>, Calendar::EVENT_TYPE_COUNT> calendarHandlers;
 
 		std::vector<SaveCreator::Save*> saves;
+		// shared so widgets showing its columns (see DataTable) can outlive a load
+		std::shared_ptr<SaveCreator::Save> currentSave;
+		SaveCreator::Autosaver autosaver;
+		SaveCreator::SaveIndex saveIndex;
+		sf::Clock playClock;
+		// since the last thumbnail was taken
+		sf::Clock thumbnailClock;
+		bool thumbnailTaken;
 
 		Graphics::Background* mainMenuBG;
 		Graphics::Background* onScreenBG;
 
 		Graphics::Renderer* renderer;
+		Assets::Loader* assets;
 
 
 		Game();
@@ -23,6 +36,13 @@ namespace Game {
 		void initSavesMenu();
 		void initNewGameMenu();
 
+		void startCareer(const Career::Setup& setup);
+		void loadSave(const std::string& path);
+		void continueDays(uint32_t days);
+		// the slot thumbnail the saves menu shows, taken from what's on screen
+		void captureThumbnail(const std::string& savePath);
+		void onCalendarEvent(const Calendar::Event& event);
+
 		void run();
 		void shutdown();
 	};
@@ -1,27 +1,44 @@
 #include "graphics.h"
+#include "atlas.h"
+#include "assets.h"
 
 namespace Graphics {
 	sf::Font* Graphics::mainFont = nullptr;
 	unsigned int Graphics::currentID = 0;
-	std::vector<Graphics::CustomTexture*> Graphics::textures = std::vector<Graphics::CustomTexture*>();
+	TextureRegistry Graphics::textures = TextureRegistry();
+	TextLayoutCache Graphics::textLayouts = TextLayoutCache();
+	std::vector<sf::Texture*> Graphics::atlasPages = std::vector<sf::Texture*>();
+	CustomTexture* Graphics::placeholderTexture = nullptr;
 	Renderer* Renderer::instance = nullptr;
 	sf::RenderWindow Renderer::window = sf::RenderWindow();
 }
 
-Graphics::ObjectBuilder::ObjectBuilder() {
-	config = new ObjectConfig();
-	config->texture = new sf::Sprite(*Graphics::getTexture(TextureNames::button)); // placeholder texture
+Graphics::ObjectBuilder::ObjectBuilder(Memory::Arena& arena, ObjectConfig* config) : config(config), arena(arena) {
+	auto placeholder = Graphics::getTexture(TextureNames::button);
+	config->texture = arena.make<sf::Sprite>(*placeholder->texture, placeholder->rect);
+	config->textureHandle = TextureNames::button;
+	Graphics::textures.acquire(TextureNames::button);
 }
 
-Graphics::ObjectBuilder& Graphics::ObjectBuilder::withTexture(const std::string& textureName) {
-	auto texture = Graphics::getTexture(textureName);
+Graphics::ObjectBuilder& Graphics::ObjectBuilder::withTexture(TextureHandle handle) {
+	auto texture = Graphics::getTexture(handle);
 	if (texture) {
-		config->texture->setTexture(*texture);
+		config->texture->setTexture(*texture->texture);
+		config->texture->setTextureRect(texture->rect);
 	}
+	// kept even while the placeholder is shown, rebindTextures swaps the real one in
+	Graphics::textures.acquire(handle);
+	Graphics::textures.release(config->textureHandle);
+	config->textureHandle = handle;
 	DEBUG("texture");
 	return *this;
 }
 
+Graphics::ObjectBuilder& Graphics::ObjectBuilder::withTexture(std::string_view textureName) {
+	// bound to the name even before the atlas is in, so rebindTextures can swap the real one in
+	return this->withTexture(Graphics::textures.reserve(textureName));
+}
+
 Graphics::ObjectBuilder& Graphics::ObjectBuilder::withName(const std::string& name) {
 	config->name = name;
 	DEBUG("name"); 
@@ -61,12 +78,15 @@ Graphics::ObjectBuilder& Graphics::ObjectBuilder::withTexturePosOffset(float x,
 }
 
 Graphics::ObjectBuilder& Graphics::ObjectBuilder::withTextureOrigin(float x, float y) {
-	config->texture->setOrigin({ config->texture->getGlobalBounds().size.x / x, config->texture->getGlobalBounds().size.y / y });
+	// kept so the origin follows the real texture once it replaces the placeholder
+	config->originDivisor = { x, y };
+	const sf::Vector2f size = config->texture->getLocalBounds().size;
+	config->texture->setOrigin({ size.x / x, size.y / y });
 	return *this;
 }
 
 Graphics::ButtonBuilder& Graphics::ButtonBuilder::withText(const std::string& text) {
-	config->text = new sf::Text(*Graphics::useMainFont());
+	config->text = this->arena.make<sf::Text>(*Graphics::useMainFont());
 	config->text->setString(text);
 	config->text->setFillColor(sf::Color::White);
 	return *this;
@@ -116,21 +136,35 @@ Graphics::ButtonBuilder& Graphics::ButtonBuilder::withTextScale(float x, float y
 	return *this;
 }
 
-inline Graphics::DropdownElementBuilder& Graphics::DropdownElementBuilder::withParent(DropdownBar* bar) {
-	config->parent = bar;
+Graphics::ScrollListBuilder& Graphics::ScrollListBuilder::withSource(std::function<size_t()> itemCount, std::function<std::string(size_t, size_t)> itemText) {
+	config->itemCount = itemCount;
+	config->itemText = itemText;
 	return *this;
 }
 
-Graphics::DropdownElement::DropdownElement(DropdownElementConfig* config) : Button() {
-	this->config = config;
+Graphics::ScrollListBuilder& Graphics::ScrollListBuilder::withColumns(const std::vector<float>& widths, float headerHeight) {
+	config->columnWidths = widths;
+	config->headerHeight = std::max(0.f, headerHeight);
+	return *this;
 }
 
-inline void Graphics::DropdownElement::changeConfig(DropdownElementConfig* config) {
-	this->config = config;
+Graphics::ScrollListBuilder& Graphics::ScrollListBuilder::withSelect(std::function<void(size_t)> onSelect) {
+	config->onSelect = onSelect;
+	return *this;
+}
+
+Graphics::ScrollListBuilder& Graphics::ScrollListBuilder::withSize(float width, float height) {
+	config->size = { width, height };
+	return *this;
+}
+
+Graphics::ScrollListBuilder& Graphics::ScrollListBuilder::withRowHeight(float rowHeight) {
+	config->rowHeight = std::max(1.f, rowHeight);
+	return *this;
 }
 
-Graphics::DropdownElement* Graphics::DropdownElementBuilder::build() {
-	auto res = new DropdownElement(config);
+Graphics::ScrollList* Graphics::ScrollListBuilder::build() {
+	auto res = this->arena.make<ScrollList>(config, this->arena);
 	if (res->getConfig()->layer) {
 		res->getConfig()->layer->addObject(res);
 	}
@@ -138,24 +172,37 @@ Graphics::DropdownElement* Graphics::DropdownElementBuilder::build() {
 }
 
 inline Graphics::DropdownBarBuilder& Graphics::DropdownBarBuilder::withContents(const std::vector<std::string>& texts) {
-	config->contents.reserve(texts.size());
-	auto elementBuilder = DropdownElementBuilder();
-	for (auto& t : texts) {
-		elementBuilder.withText(t).withTexture(TextureNames::button);
-		config->contents.emplace_back(elementBuilder.build());
-	}
+	config->items = texts;
+	return *this;
 }
 
 inline Graphics::DropdownBar* Graphics::DropdownBarBuilder::build() {
-	auto res = new DropdownBar(config);
+	auto res = this->arena.make<DropdownBar>(config);
 	if (res->getConfig()->layer) {
 		res->getConfig()->layer->addObject(res);
 	}
+
+	// the items open in a list right below the bar, placed again whenever it opens
+	const sf::FloatRect bar = config->texture->getGlobalBounds();
+	const float rowHeight = std::max(1.f, bar.size.y);
+	DropdownBarConfig* barConfig = config;
+	ScrollListBuilder listBuilder(this->arena);
+	listBuilder.withSource([barConfig]() { return barConfig->items.size(); }, [barConfig](size_t item, size_t) { return barConfig->items[item]; })
+		.withSelect([res](size_t item) { res->select(item); })
+		.withSize(bar.size.x, rowHeight * DropdownBar::visibleItems)
+		.withRowHeight(rowHeight);
+	listBuilder.withName(config->name + "_list")
+		.withTexture(TextureNames::dropdownBar)
+		.withZIndex(config->zIndex + 1)
+		.withLayer(config->layer)
+		.withTexturePos(bar.position.x, bar.position.y + bar.size.y);
+	config->list = listBuilder.build();
+	config->list->hide();
 	return res;
 }
 
 inline Graphics::InputBox* Graphics::InputBoxBuilder::build() {
-	auto res = new InputBox(config);
+	auto res = this->arena.make<InputBox>(config);
 	if (res->getConfig()->layer) {
 		res->getConfig()->layer->addObject(res);
 	}
@@ -164,7 +211,7 @@ inline Graphics::InputBox* Graphics::InputBoxBuilder::build() {
 }
 
 Graphics::Background* Graphics::BackgroundBuilder::build() {
-	Background* res = new Background(config);
+	Background* res = this->arena.make<Background>(config);
 	if (res->getConfig()->layer) {
 		res->getConfig()->layer->addObject(res);
 	}
@@ -173,7 +220,7 @@ Graphics::Background* Graphics::BackgroundBuilder::build() {
 }
 
 Graphics::Button* Graphics::ButtonBuilder::build() {
-	auto res = new Button(config);
+	auto res = this->arena.make<Button>(config);
 	if (res->getConfig()->layer) {
 		res->getConfig()->layer->addObject(res);
 	}
@@ -181,24 +228,265 @@ Graphics::Button* Graphics::ButtonBuilder::build() {
 	return res;
 }
 
-void Graphics::Layer::onRender(sf::RenderWindow& window) {
+uint32_t Graphics::Layer::onRender(sf::RenderWindow& window) {
+	const bool rebuild = this->needsRender();
+	uint32_t drawCalls = 0;
 	for (auto& objs : this->objs) {
 		if (objs.second.empty()) {
 			continue;
 		}
-		for (auto& element : objs.second) {
-			try {
-				element->render(&window);
-			}
-			catch (std::exception& e) {
-				ERROR("Faild to render texture. " << e.what());
+		SpriteBatch& batch = this->batches[objs.first];
+		if (rebuild) {
+			batch.clear();
+			for (auto& element : objs.second) {
+				try {
+					element->batch(batch);
+				}
+				catch (std::exception& e) {
+					ERROR("Faild to render texture. " << e.what());
+				}
 			}
 		}
+		drawCalls += batch.draw(window);
 	}
 
 	if (!this->continuousRendering) {
 		this->alreadyRendered = true;
 	}
+	return drawCalls;
+}
+
+sf::VertexArray& Graphics::SpriteBatch::groupFor(std::vector<Group>& groups, const sf::Texture* texture) {
+	// a screen uses a handful of textures, a linear search beats hashing them
+	for (auto& group : groups) {
+		if (group.texture == texture) {
+			return group.vertices;
+		}
+	}
+	groups.emplace_back(texture);
+	return groups.back().vertices;
+}
+
+namespace Graphics {
+	// two triangles, SFML 3 has no quad primitive
+	static void appendQuad(sf::VertexArray& vertices, const sf::Transform& transform, float left, float top, float right, float bottom,
+		float u1, float v1, float u2, float v2, sf::Color color, float shear = 0.f) {
+		const sf::Vertex topLeft{ transform.transformPoint({ left - shear * top, top }), color, { u1, v1 } };
+		const sf::Vertex topRight{ transform.transformPoint({ right - shear * top, top }), color, { u2, v1 } };
+		const sf::Vertex bottomLeft{ transform.transformPoint({ left - shear * bottom, bottom }), color, { u1, v2 } };
+		const sf::Vertex bottomRight{ transform.transformPoint({ right - shear * bottom, bottom }), color, { u2, v2 } };
+		vertices.append(topLeft);
+		vertices.append(topRight);
+		vertices.append(bottomLeft);
+		vertices.append(bottomLeft);
+		vertices.append(topRight);
+		vertices.append(bottomRight);
+	}
+}
+
+void Graphics::SpriteBatch::clear() {
+	// groups stay so their vertex storage is reused next frame
+	for (auto& group : this->sprites) {
+		group.vertices.clear();
+	}
+	for (auto& group : this->glyphs) {
+		group.vertices.clear();
+	}
+	this->unbatched.clear();
+}
+
+void Graphics::SpriteBatch::add(const sf::Sprite& sprite) {
+	const sf::IntRect& rect = sprite.getTextureRect();
+	const float width = (float)std::abs(rect.size.x);
+	const float height = (float)std::abs(rect.size.y);
+	const float u1 = (float)rect.position.x;
+	const float v1 = (float)rect.position.y;
+	appendQuad(this->groupFor(this->sprites, &sprite.getTexture()), sprite.getTransform(), 0.f, 0.f, width, height,
+		u1, v1, u1 + (float)rect.size.x, v1 + (float)rect.size.y, sprite.getColor());
+}
+
+void Graphics::SpriteBatch::add(const sf::Text& text) {
+	if (text.getOutlineThickness() != 0.f || (text.getStyle() & (sf::Text::Underlined | sf::Text::StrikeThrough))) {
+		this->unbatched.push_back(&text);
+		return;
+	}
+	this->add(Graphics::textLayouts.get(text), text);
+}
+
+void Graphics::SpriteBatch::add(const TextLayout& layout, const sf::Text& text) {
+	if (text.getOutlineThickness() != 0.f || (text.getStyle() & (sf::Text::Underlined | sf::Text::StrikeThrough))) {
+		this->unbatched.push_back(&text);
+		return;
+	}
+
+	const float shear = (text.getStyle() & sf::Text::Italic) ? 0.209f : 0.f;
+	const sf::Color color = text.getFillColor();
+	const sf::Transform& transform = text.getTransform();
+	sf::VertexArray& vertices = this->groupFor(this->glyphs, &layout.getTexture());
+	for (auto& quad : layout.getQuads()) {
+		appendQuad(vertices, transform, quad.left, quad.top, quad.right, quad.bottom, quad.u1, quad.v1, quad.u2, quad.v2, color, shear);
+	}
+}
+
+Graphics::TextLayout::TextLayout(const sf::Font& font, unsigned int size, bool bold, float letterSpacingFactor, float lineSpacingFactor)
+	: font(&font), size(size), bold(bold), letterSpacingFactor(letterSpacingFactor), lineSpacingFactor(lineSpacingFactor), quads({}), steps({}) {
+	this->whitespaceWidth = font.getGlyph(U' ', size, bold).advance;
+	this->letterSpacing = (this->whitespaceWidth / 3.f) * (letterSpacingFactor - 1.f);
+	this->whitespaceWidth += this->letterSpacing;
+	this->lineSpacing = font.getLineSpacing(size) * lineSpacingFactor;
+	this->clear();
+}
+
+Graphics::TextLayout Graphics::TextLayout::of(const sf::Text& text) {
+	TextLayout res(text.getFont(), text.getCharacterSize(), (text.getStyle() & sf::Text::Bold) != 0, text.getLetterSpacing(), text.getLineSpacing());
+	const sf::String& string = text.getString();
+	res.quads.reserve(string.getSize());
+	res.steps.reserve(string.getSize());
+	for (size_t i = 0; i < string.getSize(); i++) {
+		res.append(string[i]);
+	}
+	return res;
+}
+
+void Graphics::TextLayout::clear() {
+	this->quads.clear();
+	this->steps.clear();
+	this->x = 0.f;
+	this->y = (float)this->size;
+	this->previous = 0;
+	this->minX = (float)this->size;
+	this->minY = (float)this->size;
+	this->maxX = 0.f;
+	this->maxY = 0.f;
+}
+
+void Graphics::TextLayout::append(char32_t current) {
+	this->steps.push_back({ this->x, this->y, this->previous, this->quads.size(), this->minX, this->minY, this->maxX, this->maxY });
+	if (current == U'\r') {
+		return;
+	}
+	this->x += this->font->getKerning(this->previous, current, this->size, this->bold);
+	this->previous = current;
+
+	if (current == U' ' || current == U'\t' || current == U'\n') {
+		this->minX = std::min(this->minX, this->x);
+		this->minY = std::min(this->minY, this->y);
+		switch (current) {
+		case U' ':
+			this->x += this->whitespaceWidth;
+			break;
+		case U'\t':
+			this->x += this->whitespaceWidth * 4;
+			break;
+		default:
+			this->y += this->lineSpacing;
+			this->x = 0;
+			break;
+		}
+		this->maxX = std::max(this->maxX, this->x);
+		this->maxY = std::max(this->maxY, this->y);
+		return;
+	}
+
+	const sf::Glyph& glyph = this->font->getGlyph(current, this->size, this->bold);
+	const float padding = 1.f;
+	const float left = glyph.bounds.position.x;
+	const float top = glyph.bounds.position.y;
+	const float right = glyph.bounds.position.x + glyph.bounds.size.x;
+	const float bottom = glyph.bounds.position.y + glyph.bounds.size.y;
+	this->quads.push_back({ this->x + left - padding, this->y + top - padding, this->x + right + padding, this->y + bottom + padding,
+		(float)glyph.textureRect.position.x - padding, (float)glyph.textureRect.position.y - padding,
+		(float)(glyph.textureRect.position.x + glyph.textureRect.size.x) + padding, (float)(glyph.textureRect.position.y + glyph.textureRect.size.y) + padding });
+
+	this->minX = std::min(this->minX, this->x + left);
+	this->maxX = std::max(this->maxX, this->x + right);
+	this->minY = std::min(this->minY, this->y + top);
+	this->maxY = std::max(this->maxY, this->y + bottom);
+	this->x += glyph.advance + this->letterSpacing;
+}
+
+void Graphics::TextLayout::erase() {
+	if (this->steps.empty()) {
+		return;
+	}
+	const Step& step = this->steps.back();
+	this->x = step.x;
+	this->y = step.y;
+	this->previous = step.previous;
+	this->quads.resize(step.quads);
+	this->minX = step.minX;
+	this->minY = step.minY;
+	this->maxX = step.maxX;
+	this->maxY = step.maxY;
+	this->steps.pop_back();
+}
+
+bool Graphics::TextLayout::matches(const sf::Text& text) const {
+	return this->font == &text.getFont() && this->size == text.getCharacterSize() && this->bold == ((text.getStyle() & sf::Text::Bold) != 0)
+		&& this->letterSpacingFactor == text.getLetterSpacing() && this->lineSpacingFactor == text.getLineSpacing();
+}
+
+sf::FloatRect Graphics::TextLayout::getBounds() const {
+	if (this->steps.empty()) {
+		return {};
+	}
+	return sf::FloatRect({ this->minX, this->minY }, { this->maxX - this->minX, this->maxY - this->minY });
+}
+
+const Graphics::TextLayout& Graphics::TextLayoutCache::get(const sf::Text& text) {
+	const Style style{ &text.getFont(), text.getCharacterSize(), (text.getStyle() & sf::Text::Bold) != 0, text.getLetterSpacing(), text.getLineSpacing() };
+	const sf::String& string = text.getString();
+	const std::u32string_view view(string.getData(), string.getSize());
+
+	auto& table = this->layouts[style];
+	auto it = table.find(view);
+	if (it != table.end()) {
+		this->hits++;
+		return it->second;
+	}
+
+	this->misses++;
+	if (this->count >= maxLayouts) {
+		this->layouts.clear();
+		this->count = 0;
+		return this->layouts[style].emplace(std::u32string(view), TextLayout::of(text)).first->second;
+	}
+	this->count++;
+	return table.emplace(std::u32string(view), TextLayout::of(text)).first->second;
+}
+
+void Graphics::TextLayoutCache::clear() {
+	this->layouts.clear();
+	this->count = 0;
+}
+
+size_t Graphics::SpriteBatch::quadCount() const {
+	size_t vertices = 0;
+	for (auto& group : this->sprites) {
+		vertices += group.vertices.getVertexCount();
+	}
+	for (auto& group : this->glyphs) {
+		vertices += group.vertices.getVertexCount();
+	}
+	return vertices / 6 + this->unbatched.size();
+}
+
+uint32_t Graphics::SpriteBatch::draw(sf::RenderTarget& target) {
+	uint32_t drawCalls = 0;
+	for (auto* groups : { &this->sprites, &this->glyphs }) {
+		for (auto& group : *groups) {
+			if (group.vertices.getVertexCount() == 0) {
+				continue;
+			}
+			target.draw(group.vertices, sf::RenderStates(group.texture));
+			drawCalls++;
+		}
+	}
+	for (auto text : this->unbatched) {
+		target.draw(*text);
+		drawCalls++;
+	}
+	return drawCalls;
 }
 
 Graphics::Renderer::Renderer() : innerLayerCount(20), outerLayerCount(10) {
@@ -207,26 +495,64 @@ Graphics::Renderer::Renderer() : innerLayerCount(20), outerLayerCount(10) {
 	this->currentClickedObject = nullptr;
 	this->prevClickedObject = nullptr;
 	this->inputBoxActive = false;
+	this->drawCalls = 0;
+	this->showFrameStats = false;
+	this->redrawRequested = true;
 
 	this->window = sf::RenderWindow(sf::VideoMode({ LayoutDesign::width, LayoutDesign::height }), "manager");
+	// display() waits for the monitor, continuous layers can't outrun it
+	this->window.setVerticalSyncEnabled(true);
 	this->currentGameState = MAIN_MENU;
 }
 
 Graphics::Renderer::~Renderer() {
 }
 
-void Graphics::Renderer::refreshFrame() {
+bool Graphics::Renderer::needsFrame() const {
+	if (this->redrawRequested || !this->animating.empty()) {
+		return true;
+	}
+	for (auto& layer : this->onScreenLayers) {
+		if (layer.second->needsRender()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Graphics::Renderer::refreshFrame() {
+	if (!this->needsFrame()) {
+		return false;
+	}
+
+	if (!this->animating.empty()) {
+		const float seconds = this->animationClock.restart().asSeconds();
+		std::erase_if(this->animating, [seconds](Object* object) { return !object->animate(seconds); });
+	}
+
+	// the back buffer isn't kept between frames, so one changed layer means drawing all of them
 	this->window.clear();
+	uint32_t drawCalls = 0;
 	for (auto& layer : this->onScreenLayers) {
-		layer.second->onRender(window);
+		drawCalls += layer.second->onRender(window);
+	}
+	if (this->showFrameStats) {
+		sf::Text stats(*Graphics::useMainFont(), "draw calls: " + std::to_string(this->drawCalls), 14);
+		stats.setPosition({ 4.f, 4.f });
+		this->window.draw(stats);
+		drawCalls++;
 	}
+	this->drawCalls = drawCalls;
+	this->redrawRequested = false;
 	this->window.display();
+	return true;
 }
 
 void Graphics::Renderer::hideLayer(Layer* layer) {
 	for (auto it = this->onScreenLayers.begin(); it != this->onScreenLayers.end(); it++) {
 		if ((*it).second == layer) {
 			this->onScreenLayers.erase(it);
+			this->requestRedraw();
 			return;
 		}
 	}
@@ -236,6 +562,7 @@ void Graphics::Renderer::hideLayer(const std::string& name) {
 	for (auto it = this->onScreenLayers.begin(); it != this->onScreenLayers.end(); it++) {
 		if ((*it).second->name == name) {
 			this->onScreenLayers.erase(it);
+			this->requestRedraw();
 			return;
 		}
 	}
@@ -253,30 +580,173 @@ void Graphics::Renderer::hideLayer(const std::string& name) {
 
 void Graphics::Renderer::revealLayer(Layer* layer) {
 	this->onScreenLayers.insert({ layer->outerRenderLayer, layer });
+	this->requestRedraw();
 }
 
 void Graphics::Renderer::revealLayer(const std::string& name) {
 	for (auto& e : this->layers) {
 		if (e->name == name) {
 			this->onScreenLayers.insert({e->outerRenderLayer, e});
+			this->requestRedraw();
 		}
 	}
 }
 
-sf::Texture* Graphics::getTexture(const std::string& name) {
-	std::string fileName = name + ".png";
-	if (Graphics::textures.empty()) {
+Graphics::CustomTexture* Graphics::getTexture(TextureHandle handle) {
+	// nothing loaded and nothing on the way
+	if (Graphics::textures.empty() && !Graphics::placeholderTexture) {
 		LOG("Loading textures...");
 		Graphics::loadTextures();
 		LOG("Finished loading.");
 	}
+	CustomTexture* res = Graphics::textures.get(handle);
+	return res ? res : Graphics::placeholderTexture;
+}
 
-	for (auto& texture : Graphics::textures) {
-		if (texture->name == fileName)
-			return texture->texture;
+Graphics::CustomTexture* Graphics::getTexture(std::string_view name) {
+	if (Graphics::textures.empty() && !Graphics::placeholderTexture) {
+		LOG("Loading textures...");
+		Graphics::loadTextures();
+		LOG("Finished loading.");
 	}
+	CustomTexture* res = Graphics::textures.get(Graphics::textures.find(name));
+	return res ? res : Graphics::placeholderTexture;
+}
 
-	return nullptr;
+Graphics::TextureRegistry::TextureRegistry() : slots({}), handles({}), freeSlots({}), pageRefs({}), loaded(0) {
+	for (auto name : TextureNames::builtin) {
+		this->handles.emplace(std::string(name), (TextureHandle)this->slots.size());
+		this->slots.push_back({ std::string(name), nullptr, 0 });
+	}
+}
+
+Graphics::TextureHandle Graphics::TextureRegistry::reserve(std::string_view name) {
+	auto reserved = this->handles.find(name);
+	if (reserved != this->handles.end()) {
+		return reserved->second;
+	}
+
+	TextureHandle handle;
+	if (!this->freeSlots.empty()) {
+		handle = this->freeSlots.back();
+		this->freeSlots.pop_back();
+	}
+	else if (this->slots.size() < noTexture) {
+		handle = (TextureHandle)this->slots.size();
+		this->slots.push_back({ "", nullptr, 0 });
+	}
+	else {
+		return noTexture;
+	}
+	Slot& slot = this->slots[handle];
+	slot.name = name;
+	this->handles.emplace(slot.name, handle);
+	return handle;
+}
+
+Graphics::TextureHandle Graphics::TextureRegistry::add(std::string_view name, CustomTexture* texture) {
+	TextureHandle handle = this->reserve(name);
+	if (handle == noTexture) {
+		ERROR("Too many textures, " << name << " isn't loaded.");
+		delete texture;
+		return noTexture;
+	}
+	if (this->slots[handle].texture) {
+		ERROR("Texture " << name << " is loaded twice, only the first one is kept.");
+		delete texture;
+		return handle;
+	}
+
+	Slot& slot = this->slots[handle];
+	slot.texture = texture;
+	slot.refs++;
+	if (texture->page >= this->pageRefs.size()) {
+		this->pageRefs.resize(texture->page + 1, 0);
+	}
+	this->pageRefs[texture->page]++;
+	this->loaded++;
+	return handle;
+}
+
+Graphics::TextureHandle Graphics::TextureRegistry::find(std::string_view name) const {
+	auto it = this->handles.find(name);
+	if (it == this->handles.end() || !this->slots[it->second].texture) {
+		return noTexture;
+	}
+	return it->second;
+}
+
+void Graphics::TextureRegistry::acquire(TextureHandle handle) {
+	// reserved slots are counted before their texture arrives
+	if (handle < this->slots.size() && !this->slots[handle].name.empty()) {
+		this->slots[handle].refs++;
+	}
+}
+
+void Graphics::TextureRegistry::release(TextureHandle handle) {
+	if (handle >= this->slots.size() || this->slots[handle].refs == 0) {
+		return;
+	}
+	if (--this->slots[handle].refs > 0) {
+		return;
+	}
+	if (this->slots[handle].texture) {
+		this->free(handle);
+	}
+	else {
+		// reserved under a name that was never loaded, a typo or a dynamic name
+		this->recycle(handle);
+	}
+}
+
+void Graphics::TextureRegistry::free(TextureHandle handle) {
+	Slot& slot = this->slots[handle];
+	const uint32_t page = slot.texture->page;
+	delete slot.texture;
+	slot.texture = nullptr;
+	this->loaded--;
+	if (--this->pageRefs[page] == 0 && page < Graphics::atlasPages.size()) {
+		delete Graphics::atlasPages[page];
+		Graphics::atlasPages[page] = nullptr;
+	}
+	this->recycle(handle);
+}
+
+void Graphics::TextureRegistry::recycle(TextureHandle handle) {
+	// builtin slots stay reserved for their name, the rest are reused
+	if (handle < std::size(TextureNames::builtin)) {
+		return;
+	}
+	Slot& slot = this->slots[handle];
+	this->handles.erase(this->handles.find(std::string_view(slot.name)));
+	slot.name.clear();
+	this->freeSlots.push_back(handle);
+}
+
+void Graphics::TextureRegistry::clear() {
+	for (auto& slot : this->slots) {
+		delete slot.texture;
+	}
+	this->slots.resize(std::size(TextureNames::builtin));
+	for (auto& slot : this->slots) {
+		slot.texture = nullptr;
+		slot.refs = 0;
+	}
+	this->handles.clear();
+	for (size_t i = 0; i < this->slots.size(); i++) {
+		this->handles.emplace(this->slots[i].name, (TextureHandle)i);
+	}
+	this->freeSlots.clear();
+	this->pageRefs.clear();
+	this->loaded = 0;
+}
+
+bool Graphics::TextureRegistry::empty() const {
+	return this->loaded == 0;
+}
+
+size_t Graphics::TextureRegistry::size() const {
+	return this->loaded;
 }
 
 Graphics::Object* Graphics::getObjectByCords(float x, float y, std::vector<Graphics::Object*> onScreenObjs) {
@@ -288,66 +758,137 @@ Graphics::Object* Graphics::getObjectByCords(float x, float y, std::vector<Graph
 	return nullptr;
 }
 
-void Graphics::loadMainFont() {
+std::filesystem::path Graphics::mainFontPath() {
 	try {
 		for (const auto& tex : std::filesystem::directory_iterator("res\\fonts")) {
 			if (tex.is_regular_file() && tex.path().filename().string()[0] == 'm' && tex.path().filename().string()[1] == '_') {
-				Graphics::mainFont = new sf::Font(tex.path());
-				return;
+				return tex.path();
 			}
 		}
 	}
 	catch (const std::filesystem::filesystem_error& e) {
 		ERROR("Error: " << e.what());
 	}
+	return {};
 }
 
-void Graphics::loadTextures() {  
-	Graphics::textures = std::vector<Graphics::CustomTexture*>();
-	Graphics::textures.reserve(10);
+void Graphics::loadMainFont() {
+	const std::filesystem::path path = Graphics::mainFontPath();
+	if (!path.empty()) {
+		Graphics::mainFont = new sf::Font(path);
+	}
+}
 
-	try {  
-		for (const auto& subfolder : std::filesystem::directory_iterator("res")) {  
+std::vector<std::filesystem::path> Graphics::textureSources() {
+	std::vector<std::filesystem::path> sources;
+	try {
+		for (const auto& subfolder : std::filesystem::directory_iterator("res")) {
 			if (subfolder.is_directory() && subfolder.path().filename().string() != "fonts" && subfolder.path().filename().string() != "names") {
-				for (const auto& tex : std::filesystem::directory_iterator(subfolder)) {  
-					if (tex.is_regular_file()) {  
-						sf::Texture* texture = new sf::Texture();  
-						if (texture->loadFromFile(tex.path().string())) {  
-							Graphics::textures.push_back(new Graphics::CustomTexture(tex.path().filename().string(), texture));
-						}
-					}  
-				}  
-			}  
-		}  
-	}  
-	catch (const std::filesystem::filesystem_error& e) {  
+				for (const auto& tex : std::filesystem::directory_iterator(subfolder)) {
+					if (tex.is_regular_file()) {
+						sources.push_back(tex.path());
+					}
+				}
+			}
+		}
+	}
+	catch (const std::filesystem::filesystem_error& e) {
 		ERROR("Error: " << e.what());
-	}  
+	}
+	return sources;
 }
 
-void Graphics::deloadTextures() {
-	for (auto tex : Graphics::textures) {
-		delete tex;
+void Graphics::loadTextures() {
+	// every UI image shares one or a few pages, so widgets of different kinds still batch together
+	Atlas::Atlas atlas = Atlas::build(Graphics::textureSources(), textureCacheDirectory);
+	std::vector<sf::Texture*> pages;
+	for (auto& page : atlas.pages) {
+		sf::Texture* texture = new sf::Texture();
+		if (!texture->loadFromImage(page)) {
+			ERROR("Couldn't upload a texture atlas page.");
+		}
+		pages.push_back(texture);
+	}
+	Graphics::addAtlas(atlas, pages);
+}
+
+void Graphics::addAtlas(const Atlas::Atlas& atlas, const std::vector<sf::Texture*>& pages) {
+	const uint32_t firstPage = (uint32_t)Graphics::atlasPages.size();
+	Graphics::atlasPages.insert(Graphics::atlasPages.end(), pages.begin(), pages.end());
+	for (auto& entry : atlas.entries) {
+		const std::string name = std::filesystem::path(entry.name).stem().string();
+		const uint32_t page = firstPage + entry.page;
+		// a page that couldn't be uploaded, the name stays on the placeholder
+		if (!Graphics::atlasPages[page]) {
+			continue;
+		}
+		Graphics::textures.add(name, new Graphics::CustomTexture(name, Graphics::atlasPages[page], page, entry.rect));
+	}
+	for (auto name : TextureNames::builtin) {
+		if (Graphics::textures.find(name) == noTexture) {
+			ERROR("Builtin texture " << name << " is missing.");
+		}
 	}
+}
+
+void Graphics::createPlaceholderTexture() {
+	if (Graphics::placeholderTexture) {
+		return;
+	}
+	sf::Texture* texture = new sf::Texture();
+	if (!texture->loadFromImage(sf::Image({ 8, 8 }, sf::Color(96, 96, 96)))) {
+		ERROR("Couldn't create the placeholder texture.");
+	}
+	Graphics::placeholderTexture = new CustomTexture("placeholder", texture, UINT32_MAX, sf::IntRect({ 0, 0 }, { 8, 8 }));
+}
+
+Graphics::TextureHandle Graphics::addImageTexture(const std::string& name, const sf::Image& image) {
+	sf::Texture* texture = new sf::Texture();
+	if (!texture->loadFromImage(image)) {
+		ERROR("Couldn't upload the texture " << name << ".");
+		delete texture;
+		return noTexture;
+	}
+	const uint32_t page = (uint32_t)Graphics::atlasPages.size();
+	Graphics::atlasPages.push_back(texture);
+	return Graphics::textures.add(name, new CustomTexture(name, texture, page, sf::IntRect({ 0, 0 }, (sf::Vector2i)image.getSize())));
+}
+
+void Graphics::deloadTextures() {
 	Graphics::textures.clear();
+	if (Graphics::placeholderTexture) {
+		delete Graphics::placeholderTexture->texture;
+		delete Graphics::placeholderTexture;
+		Graphics::placeholderTexture = nullptr;
+	}
+	for (auto page : Graphics::atlasPages) {
+		delete page;
+	}
+	Graphics::atlasPages.clear();
 }
 
 void Graphics::deloadFont() {
+	Graphics::textLayouts.clear();
 	delete Graphics::mainFont;
 }
 
-Graphics::CustomTexture::CustomTexture(const std::string& name, sf::Texture* tex) {
+Graphics::CustomTexture::CustomTexture(const std::string& name, const sf::Texture* texture, uint32_t page, const sf::IntRect& rect) {
 	this->name = name;
-	this->texture = tex;
+	this->texture = texture;
+	this->page = page;
+	this->rect = rect;
 }
 
-Graphics::Object::Object(ObjectConfig* config) {
-	this->config = new ObjectConfig(config->texture, config->name, config->handler, config->zIndex, config->layer);
-	DEBUG("CONFGI");
+Graphics::ObjectConfig::~ObjectConfig() {
+	Graphics::textures.release(this->textureHandle);
 }
 
-Graphics::Button::Button(ButtonConfig* config) {
+Graphics::Object::Object(ObjectConfig* config) : config(config), kind(BACKGROUND), capabilities(0) {
+}
+
+Graphics::Button::Button(ButtonConfig* config) : Object(config) {
 	this->config = config;
+	this->setKind(BUTTON, HOVERABLE | FOCUSABLE);
 }
 
 inline void Graphics::Button::changeConfig(ButtonConfig* config) {
@@ -362,7 +903,7 @@ inline Graphics::InputBoxConfig* Graphics::InputBox::getConfig() {
 	return this->config;
 }
 
-inline Graphics::DropdownElementConfig* Graphics::DropdownElement::getConfig() {
+Graphics::ScrollListConfig* Graphics::ScrollList::getConfig() {
 	return this->config;
 }
 
@@ -389,14 +930,17 @@ inline Graphics::ObjectConfig* Graphics::Object::getConfig() {
 inline void Graphics::Button::hide() {
 	this->config->texture->setColor(sf::Color(255, 255, 255, 0));
 	this->config->text->setFillColor(sf::Color(255, 255, 255, 0));
+	this->markDirty();
 }
 
 inline void Graphics::Button::reveal() {
 	this->config->texture->setColor(sf::Color(255, 255, 255, 255));
 	this->config->text->setFillColor(sf::Color(255, 255, 255, 255));
+	this->markDirty();
 }
 
 void Graphics::Button::onPress() {
+	Replay::recordButton(this->config->name);
 	if (this->config->handler) {
 		this->config->handler();
 	}
@@ -418,7 +962,20 @@ void Graphics::Button::render(sf::RenderWindow* window) {
 	}
 }
 
-inline bool Graphics::Object::isVisible() const {
+void Graphics::Button::batch(SpriteBatch& batch) {
+	if (this->config->texture && this->config->text && this->isVisible()) {
+		batch.add(*this->config->texture);
+		batch.add(*this->config->text);
+	}
+}
+
+void Graphics::Background::batch(SpriteBatch& batch) {
+	if (this->config->texture && this->isVisible()) {
+		batch.add(*this->config->texture);
+	}
+}
+
+bool Graphics::Object::isVisible() const {
 	return (this->config->texture->getColor().a != (uint8_t)0);
 }
 
@@ -437,52 +994,101 @@ void Graphics::InputBox::render(sf::RenderWindow* window) {
 	}
 }
 
+void Graphics::InputBox::batch(SpriteBatch& batch) {
+	if (this->config->texture && this->config->text && this->config->description && this->isVisible()) {
+		this->syncLayout();
+		batch.add(*this->config->texture);
+		batch.add(this->layout, *this->config->text);
+		batch.add(*this->config->description);
+	}
+}
+
+void Graphics::DropdownBar::batch(SpriteBatch& batch) {
+	if (this->config->texture && this->config->text && this->config->description && this->isVisible()) {
+		batch.add(*this->config->texture);
+		batch.add(*this->config->text);
+		batch.add(*this->config->description);
+	}
+}
+
 void Graphics::DropdownBar::render(sf::RenderWindow* window) {
 	if (this->config->texture && this->config->text && this->config->description && this->isVisible()) {
 		window->draw(*this->config->texture);
 		window->draw(*this->config->text);
 		window->draw(*this->config->description);
-		for (auto& e : this->config->contents) {
-			e->render(window);
-		}
 	}
 }
 
 inline void Graphics::Button::changePos(float x, float y) {
 	this->config->texture->setPosition({ x,y });
 	this->config->text->setPosition({ x,y });
+	this->markMoved();
 }
 
 inline void Graphics::Button::move(float x, float y) {
 	this->config->texture->move({ x,y });
 	this->config->text->move({ x,y });
+	this->markMoved();
+}
+
+void Graphics::Object::markDirty() {
+	Layer* layer = this->getConfig()->layer;
+	if (layer) {
+		layer->markDirty();
+	}
+	else {
+		// objects that were never added to a layer
+		Renderer::getRender()->requestRedraw();
+	}
+}
+
+void Graphics::Object::markMoved() {
+	Renderer::getRender()->objectMoved(this);
+	this->markDirty();
+}
+
+void Graphics::Object::textureBound() {
+	ObjectConfig* config = this->getConfig();
+	if (config->originDivisor.x != 0.f && config->originDivisor.y != 0.f) {
+		const sf::Vector2f size = config->texture->getLocalBounds().size;
+		config->texture->setOrigin({ size.x / config->originDivisor.x, size.y / config->originDivisor.y });
+	}
 }
 
 inline void Graphics::Object::hide() {
 	this->config->texture->setColor(sf::Color(255, 255, 255, 0));
+	this->markDirty();
 }
 
 inline void Graphics::Object::reveal() {
 	this->config->texture->setColor(sf::Color(255, 255, 255, 255));
+	this->markDirty();
 }
 
 inline void Graphics::Object::onHover() {
 	this->config->texture->setColor(sf::Color(0, 0, 0, 128));
+	this->markDirty();
 }
 
 inline void Graphics::Object::onHoverLoss() {
 	this->config->texture->setColor(sf::Color(255, 255, 255, 255));
+	this->markDirty();
 }
 
 inline void Graphics::Object::changePos(float x, float y) {
 	this->config->texture->setPosition({ x,y });
+	this->markMoved();
 }
 
 inline void Graphics::Object::move(float x, float y) {
 	this->config->texture->move({ x,y });
+	this->markMoved();
 }
 
 sf::Font* Graphics::useMainFont() {
+	// the loader normally has it by now, this only blocks on a font still on its way
+	if (!Graphics::mainFont)
+		Assets::Loader::getLoader()->require(Assets::mainFontAsset);
 	if (!Graphics::mainFont)
 		Graphics::loadMainFont();
 
@@ -491,84 +1097,351 @@ sf::Font* Graphics::useMainFont() {
 
 Graphics::Background::Background(BackgroundConfig* config) : Object(config) {
 	this->config = config;
+	this->setKind(BACKGROUND, 0);
 }
 
 Graphics::InputBox::InputBox(InputBoxConfig* config) : Button(config) {
 	this->config = config;
+	this->setKind(INPUT_BOX, HOVERABLE | FOCUSABLE | TEXT_INPUT);
+}
+
+void Graphics::InputBox::syncLayout() {
+	// anything that set the string without going through changeText
+	const sf::Text& text = *this->config->text;
+	if (!this->layout.matches(text) || this->layout.length() != text.getString().getSize()) {
+		this->layout = TextLayout::of(text);
+	}
 }
 
 void Graphics::InputBox::changeText(const char& newChar, bool removeChar) {
+	this->syncLayout();
+	sf::String string = this->config->text->getString();
 	if (removeChar) {
 	this->config->description->setFillColor(sf::Color::Black);
-		this->config->text->setString( this->config->text->getString().substring(0, this->config->text->getString().getSize() - 1) );
-		if (this->config->text->getString().getSize() > 1) {
-			this->config->text->setPosition(this->config->texture->getPosition());
+		if (!string.isEmpty()) {
+			string.erase(string.getSize() - 1);
+			this->layout.erase();
 		}
 	}
 	else {
-		this->config->text->setString((this->config->text->getString() + sf::String(newChar)).toUtf32());
-		if (this->config->text->getString().getSize() > 1) {
-			this->config->text->setPosition(this->config->texture->getPosition());
+		const sf::String added(newChar);
+		string += added;
+		for (size_t i = 0; i < added.getSize(); i++) {
+			this->layout.append(added[i]);
 		}
 	}
-	this->config->text->setOrigin({ this->config->text->getGlobalBounds().size.x / 2.f, this->config->text->getOrigin().y });
+	this->config->text->setString(string);
+	if (string.getSize() > 1) {
+		this->config->text->setPosition(this->config->texture->getPosition());
+	}
+	// the layout's bounds are what sf::Text would have laid the whole string out again for
+	this->config->text->setOrigin({ this->layout.getBounds().size.x / 2.f, this->config->text->getOrigin().y });
+	this->markDirty();
 }
 
 void Graphics::InputBox::onPress() {
 	this->config->text->setString("");
-	this->config->text->setOrigin({ this->config->text->getGlobalBounds().size.x / 2.f, this->config->text->getOrigin().y });
+	this->layout.clear();
+	this->config->text->setOrigin({ 0.f, this->config->text->getOrigin().y });
 	this->config->text->setPosition(this->config->texture->getPosition());
+	this->markDirty();
 }
 
 void Graphics::InputBox::onFocusLoss() {
+	Replay::recordText(this->config->name, this->config->text->getString().toAnsiString());
 	if (this->config->text->getString() == "") {
 		this->config->text->setString("Input");
-		this->config->text->setOrigin({ this->config->text->getGlobalBounds().size.x / 2.f, this->config->text->getOrigin().y });
+		this->layout = TextLayout::of(*this->config->text);
+		this->config->text->setOrigin({ this->layout.getBounds().size.x / 2.f, this->config->text->getOrigin().y });
 		this->config->text->setPosition(this->config->texture->getPosition());
 	}
+	this->markDirty();
 }
 
-Graphics::DropdownBar::DropdownBar(DropdownBarConfig* config) : Button() {
+Graphics::DropdownBar::DropdownBar(DropdownBarConfig* config) : Button(config) {
 	this->config = config;
+	this->setKind(DROPDOWN_BAR, HOVERABLE | FOCUSABLE);
 }
 
-Graphics::DropdownBar::~DropdownBar() {
-	for (auto e : this->config->contents) {
-		delete e;
+void Graphics::DropdownBar::onFocusLoss() {
+	// a click on the list takes the focus too, its onPress still picks the item afterwards
+	if (this->config->list) {
+		this->config->list->hide();
 	}
-	delete this->config->text;
-	delete this->config->description;
 }
 
-void Graphics::DropdownBar::onFocusLoss() {
-	for (auto& e : this->config->contents) {
-		e->hide();
+void Graphics::DropdownBar::onPress() {
+	if (this->config->items.empty() || !this->config->list) {
+		ERROR("No content has been added.");
+		return;
+	}
+	if (this->config->list->isVisible()) {
+		this->config->list->hide();
+	}
+	else {
+		// the bar may have moved since the list was placed
+		this->placeList();
+		this->config->list->reveal();
+		DEBUG(this->config->name << " opened " << this->config->items.size() << " items");
 	}
 }
 
-void Graphics::DropdownBar::onPress() {
-	if (!this->config->contents.empty()) {
-		for (int i = 0; i < this->config->contents.size(); i++) {
-			this->config->contents[i]->setPosition(this->config->contents[i]->getConfig()->parent->getConfig()->texture->getGlobalBounds().size.x, this->config->texture->getGlobalBounds().size.y * (i + 1));
-			this->config->contents[i]->reveal();
-			DEBUG(this->config->contents[i]->getConfig()->name << " revealed");
+void Graphics::DropdownBar::placeList() {
+	if (!this->config->list) {
+		return;
+	}
+	const sf::FloatRect bar = this->config->texture->getGlobalBounds();
+	const float rowHeight = std::max(1.f, bar.size.y);
+	const size_t shown = std::clamp<size_t>(this->config->items.size(), 1, visibleItems);
+	this->config->list->place(bar.position.x, bar.position.y + bar.size.y, bar.size.x, rowHeight * shown, rowHeight);
+}
+
+void Graphics::DropdownBar::textureBound() {
+	Button::textureBound();
+	this->placeList();
+}
+
+void Graphics::DropdownBar::select(size_t item) {
+	if (item >= this->config->items.size()) {
+		return;
+	}
+	if (this->config->text) {
+		this->config->text->setString(this->config->items[item]);
+	}
+	if (this->config->list) {
+		this->config->list->hide();
+	}
+	this->markDirty();
+}
+
+Graphics::ScrollList::ScrollList(ScrollListConfig* config, Memory::Arena& arena) : Object(config), config(config), rows({}), offset(0.f), targetOffset(0.f) {
+	this->setKind(SCROLL_LIST, FOCUSABLE | SCROLLABLE);
+	this->fitFrame();
+
+	// enough for every row that can be partly in view, the ones above and below included
+	const size_t visible = (size_t)std::ceil(std::max(0.f, config->size.y - config->headerHeight) / config->rowHeight) + 1;
+	this->rows.reserve(visible + 2 * overscan);
+	const unsigned int characterSize = (unsigned int)(config->rowHeight * 0.6f);
+	for (size_t i = 0; i < visible + 2 * overscan; i++) {
+		CustomTexture* texture = Graphics::getTexture(TextureNames::button);
+		Row row;
+		row.background = arena.make<sf::Sprite>(*texture->texture, texture->rect);
+		for (size_t column = 0; column < this->columnCount(); column++) {
+			row.cells.push_back(arena.make<sf::Text>(*Graphics::useMainFont(), "", characterSize));
 		}
+		row.item = SIZE_MAX;
+		row.visible = false;
+		row.textVisible = false;
+		this->rows.push_back(row);
 	}
-	else {
-		ERROR("No content has been added.");
+}
+
+sf::FloatRect Graphics::ScrollList::viewport() const {
+	sf::FloatRect res = this->config->texture->getGlobalBounds();
+	const float header = std::min(this->config->headerHeight, res.size.y);
+	res.position.y += header;
+	res.size.y -= header;
+	return res;
+}
+
+float Graphics::ScrollList::columnStart(size_t column) const {
+	float res = 0.f;
+	for (size_t i = 0; i < column && i < this->config->columnWidths.size(); i++) {
+		res += this->config->columnWidths[i];
+	}
+	return res;
+}
+
+void Graphics::ScrollList::fitFrame() {
+	const sf::IntRect& rect = this->config->texture->getTextureRect();
+	const sf::Vector2f scale = { this->config->size.x / std::max(1, rect.size.x), this->config->size.y / std::max(1, rect.size.y) };
+	if (this->config->texture->getScale() != scale) {
+		this->config->texture->setScale(scale);
+		Renderer::getRender()->objectMoved(this);
+	}
+}
+
+void Graphics::ScrollList::textureBound() {
+	Object::textureBound();
+	this->fitFrame();
+}
+
+void Graphics::ScrollList::place(float x, float y, float width, float height, float rowHeight) {
+	this->config->rowHeight = std::max(1.f, rowHeight);
+	const size_t fullRows = this->rows.size() - 1 - 2 * overscan;
+	this->config->size = { width, std::min(height, this->config->headerHeight + fullRows * this->config->rowHeight) };
+	this->config->texture->setPosition({ x, y });
+	this->fitFrame();
+	this->refresh();
+	this->markMoved();
+}
+
+float Graphics::ScrollList::maxOffset() const {
+	const size_t count = this->config->itemCount ? this->config->itemCount() : 0;
+	return std::max(0.f, count * this->config->rowHeight - this->viewport().size.y);
+}
+
+void Graphics::ScrollList::layoutRows() {
+	this->fitFrame();
+	const sf::FloatRect view = this->viewport();
+	const float viewBottom = view.position.y + view.size.y;
+	const float rowHeight = this->config->rowHeight;
+	const size_t count = this->config->itemCount ? this->config->itemCount() : 0;
+	// resolved every time, the atlas may have arrived since the rows were made
+	CustomTexture* texture = Graphics::getTexture(TextureNames::button);
+
+	const size_t firstInView = (size_t)std::max(0.f, std::floor(this->offset / rowHeight));
+	const size_t first = firstInView > overscan ? firstInView - overscan : 0;
+	for (auto& row : this->rows) {
+		row.visible = false;
+		row.textVisible = false;
+	}
+	for (size_t item = first; item < first + this->rows.size() && item < count; item++) {
+		Row& row = this->rows[item % this->rows.size()];
+		if (row.item != item) {
+			for (size_t column = 0; column < row.cells.size(); column++) {
+				row.cells[column]->setString(this->config->itemText ? this->config->itemText(item, column) : "");
+			}
+			row.item = item;
+		}
+
+		const float top = view.position.y + item * rowHeight - this->offset;
+		const float bottom = top + rowHeight;
+		const float clipTop = std::max(top, view.position.y);
+		const float clipBottom = std::min(bottom, viewBottom);
+		if (!texture || clipBottom <= clipTop) {
+			continue;
+		}
+
+		// only the part inside the viewport is drawn, cut out of the texture the same way
+		const sf::IntRect& rect = texture->rect;
+		const float scaleY = rowHeight / std::max(1, rect.size.y);
+		const int skipped = std::min(rect.size.y - 1, (int)((clipTop - top) / scaleY));
+		const int kept = std::clamp((int)std::ceil((clipBottom - clipTop) / scaleY), 1, rect.size.y - skipped);
+		row.background->setTexture(*texture->texture);
+		row.background->setTextureRect(sf::IntRect({ rect.position.x, rect.position.y + skipped }, { rect.size.x, kept }));
+		row.background->setScale({ view.size.x / std::max(1, rect.size.x), scaleY });
+		row.background->setPosition({ view.position.x, clipTop });
+		row.visible = true;
+
+		for (size_t column = 0; column < row.cells.size(); column++) {
+			sf::Text* cell = row.cells[column];
+			cell->setPosition({ view.position.x + this->columnStart(column) + rowHeight * 0.25f, top + (rowHeight - cell->getCharacterSize()) / 2.f });
+		}
+		row.textVisible = top >= view.position.y && bottom <= viewBottom;
+	}
+}
+
+void Graphics::ScrollList::batch(SpriteBatch& batch) {
+	if (!this->config->texture || !this->isVisible()) {
+		return;
+	}
+	this->layoutRows();
+	batch.add(*this->config->texture);
+	for (auto& row : this->rows) {
+		if (row.visible) {
+			batch.add(*row.background);
+		}
+	}
+	for (auto& row : this->rows) {
+		if (row.textVisible) {
+			for (auto cell : row.cells) {
+				batch.add(*cell);
+			}
+		}
 	}
 }
 
+void Graphics::ScrollList::render(sf::RenderWindow* window) {
+	if (!this->config->texture || !this->isVisible()) {
+		return;
+	}
+	this->layoutRows();
+	window->draw(*this->config->texture);
+	for (auto& row : this->rows) {
+		if (row.visible) {
+			window->draw(*row.background);
+		}
+		if (row.textVisible) {
+			for (auto cell : row.cells) {
+				window->draw(*cell);
+			}
+		}
+	}
+}
+
+size_t Graphics::ScrollList::itemAt(sf::Vector2f point) const {
+	const sf::FloatRect view = this->viewport();
+	if (!view.contains(point)) {
+		return SIZE_MAX;
+	}
+	const size_t count = this->config->itemCount ? this->config->itemCount() : 0;
+	const size_t item = (size_t)((point.y - view.position.y + this->offset) / this->config->rowHeight);
+	return item < count ? item : SIZE_MAX;
+}
+
+void Graphics::ScrollList::onPress() {
+	const size_t item = this->itemAt((sf::Vector2f)sf::Mouse::getPosition(Renderer::window));
+	if (item != SIZE_MAX && this->config->onSelect) {
+		this->config->onSelect(item);
+	}
+}
+
+void Graphics::ScrollList::scroll(float wheelDelta) {
+	this->targetOffset = std::clamp(this->targetOffset - wheelDelta * wheelRows * this->config->rowHeight, 0.f, this->maxOffset());
+	if (this->targetOffset != this->offset) {
+		Renderer::getRender()->startAnimating(this);
+	}
+}
+
+void Graphics::ScrollList::scrollTo(size_t item) {
+	this->targetOffset = std::clamp(item * this->config->rowHeight, 0.f, this->maxOffset());
+	if (this->targetOffset != this->offset) {
+		Renderer::getRender()->startAnimating(this);
+	}
+}
+
+bool Graphics::ScrollList::animate(float seconds) {
+	this->offset += (this->targetOffset - this->offset) * (1.f - std::exp(-scrollEase * seconds));
+	if (std::abs(this->targetOffset - this->offset) < 0.5f) {
+		this->offset = this->targetOffset;
+	}
+	this->markDirty();
+	return this->offset != this->targetOffset;
+}
+
+void Graphics::ScrollList::refresh() {
+	for (auto& row : this->rows) {
+		row.item = SIZE_MAX;
+	}
+	this->targetOffset = std::min(this->targetOffset, this->maxOffset());
+	this->offset = std::min(this->offset, this->maxOffset());
+	this->markDirty();
+}
+
+void Graphics::Renderer::startAnimating(Object* object) {
+	if (this->animating.empty()) {
+		this->animationClock.restart();
+	}
+	if (std::find(this->animating.begin(), this->animating.end(), object) == this->animating.end()) {
+		this->animating.push_back(object);
+	}
+}
+
+void Graphics::Renderer::stopAnimating(Layer* layer) {
+	std::erase_if(this->animating, [layer](Object* object) { return object->getConfig()->layer == layer; });
+}
+
 void Graphics::Renderer::handleHover(std::optional<sf::Event> event) {
 	if (event->is<sf::Event::MouseMoved>()) {
 		this->currentTargetObject = this->getTargetObject((sf::Vector2f)sf::Mouse::getPosition(this->window), &this->onScreenLayers);
 		
 		if (this->prevTargetObject != this->currentTargetObject) {
 
-			if (this->prevTargetObject) {
+			if (this->prevTargetObject && this->prevTargetObject->has(HOVERABLE)) {
 				this->prevTargetObject->onHoverLoss();
 			}
-			if (!dynamic_cast<Graphics::Background*>(this->currentTargetObject) && this->currentTargetObject) {
+			if (this->currentTargetObject && this->currentTargetObject->has(HOVERABLE)) {
 				this->currentTargetObject->onHover();
 			}
 
@@ -584,15 +1457,18 @@ void Graphics::Renderer::handleClick(std::optional<sf::Event> event) {
 		// focus loss
 		if (this->currentClickedObject != this->prevClickedObject && this->prevClickedObject) {
 			this->prevClickedObject->onFocusLoss();
-			if (dynamic_cast<Graphics::InputBox*>(this->prevClickedObject)) {
+			if (this->prevClickedObject->has(TEXT_INPUT)) {
 				this->inputBoxActive = false;
 			}
 		}
 
 		// clicked object
-		if (mouseButtonPressed->button == sf::Mouse::Button::Left && this->currentClickedObject && this->currentClickedObject != this->prevClickedObject) {
+		// a list takes every click, each one can be on another item
+		if (mouseButtonPressed->button == sf::Mouse::Button::Left && this->currentClickedObject
+			&& (this->currentClickedObject != this->prevClickedObject || this->currentClickedObject->has(SCROLLABLE))
+			&& this->currentClickedObject->has(FOCUSABLE)) {
 			this->currentClickedObject->onPress();
-			if (dynamic_cast<Graphics::InputBox*>(this->currentClickedObject)) {
+			if (this->currentClickedObject->has(TEXT_INPUT)) {
 				this->inputBoxActive = true;
 			}
 		}
@@ -601,38 +1477,60 @@ void Graphics::Renderer::handleClick(std::optional<sf::Event> event) {
 }
 
 void Graphics::Renderer::handleKeyPress(std::optional<sf::Event> event) {
-	if (this->inputBoxActive && event->getIf<sf::Event::TextEntered>()) {
-		const auto* text = event->getIf<sf::Event::TextEntered>();
-		if (dynamic_cast<Graphics::InputBox*>(this->currentClickedObject) && text->unicode != 8) {
-			dynamic_cast<Graphics::InputBox*>(this->currentClickedObject)->changeText(text->unicode);
+	if (const auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
+		if (keyPressed->code == sf::Keyboard::Key::F3) {
+			this->showFrameStats = !this->showFrameStats;
+			this->requestRedraw();
 		}
-		else {
-			dynamic_cast<Graphics::InputBox*>(this->currentClickedObject)->changeText({}, true);
+	}
+	const auto* text = event->getIf<sf::Event::TextEntered>();
+	Graphics::Object* target = this->currentClickedObject;
+	if (!text || !this->inputBoxActive || !target || !target->has(TEXT_INPUT)) {
+		return;
+	}
+
+	switch (target->getKind()) {
+	case INPUT_BOX: {
+		InputBox* box = static_cast<InputBox*>(target);
+		if (text->unicode == 8) {
+			box->changeText({}, true);
+		}
+		else if (text->unicode >= 32) {
+			// enter, escape and the other control characters aren't text
+			box->changeText((char)text->unicode);
 		}
+		break;
+	}
+	default:
+		ERROR(target->getConfig()->name << " takes text input but nothing routes it.");
+		break;
 	}
 }
 
 void Graphics::Renderer::handleScroll(std::optional<sf::Event> event) {
-	if (const auto* mouseWheelScrolled = event->getIf<sf::Event::MouseWheelScrolled>()) {
-		switch (mouseWheelScrolled->wheel) {
-		case sf::Mouse::Wheel::Vertical:
-			std::cout << "wheel type: vertical" << std::endl;
-			break;
-		case sf::Mouse::Wheel::Horizontal:
-			std::cout << "wheel type: horizontal" << std::endl;
-			break;
-		}
+	const auto* mouseWheelScrolled = event->getIf<sf::Event::MouseWheelScrolled>();
+	if (!mouseWheelScrolled || mouseWheelScrolled->wheel != sf::Mouse::Wheel::Vertical) {
+		return;
+	}
+	Graphics::Object* target = this->getTargetObject((sf::Vector2f)mouseWheelScrolled->position, &this->onScreenLayers);
+	if (!target || !target->has(SCROLLABLE)) {
+		return;
+	}
+
+	switch (target->getKind()) {
+	case SCROLL_LIST:
+		static_cast<ScrollList*>(target)->scroll(mouseWheelScrolled->delta);
+		break;
+	default:
+		ERROR(target->getConfig()->name << " scrolls but nothing routes it.");
+		break;
 	}
 }
 
 Graphics::Object* Graphics::Renderer::getTargetObject(const sf::Vector2f& mousePos, std::map<uint8_t, Graphics::Layer*>* list) {
-	for (auto& outerLayers : *list) {
-		for (size_t layerIT = outerLayers.second->objs.size(); layerIT != -1; layerIT--) {
-			for (auto& it : outerLayers.second->objs[layerIT]) {
-				if (it->contains(mousePos.x, mousePos.y) && it->isVisible()) {
-					return it;
-				}
-			}
+	for (auto it = list->rbegin(); it != list->rend(); it++) {
+		if (Graphics::Object* res = it->second->hitGrid.at(mousePos)) {
+			return res;
 		}
 	}
 	return nullptr;
@@ -641,7 +1539,7 @@ Graphics::Object* Graphics::Renderer::getTargetObject(const sf::Vector2f& mouseP
 Graphics::Object* Graphics::Renderer::getTargetObject(const std::string& name, std::map<uint8_t, Graphics::Layer*>* list) {
 	for (auto& outerLayers : *list) {
 		for (auto& layer : outerLayers.second->objs) {
-			for (auto it = layer.second.end() - 1; it != layer.second.begin(); it--) {
+			for (auto it = layer.second.rbegin(); it != layer.second.rend(); it++) {
 				if ((*it)->getConfig()->name == name) {
 					return (*it);
 				}
@@ -651,15 +1549,138 @@ Graphics::Object* Graphics::Renderer::getTargetObject(const std::string& name, s
 	return nullptr;
 }
 
+void Graphics::Renderer::objectMoved(Graphics::Object* object) {
+	// an object can sit on more than one layer
+	for (auto& layer : this->layers) {
+		layer->hitGrid.update(object);
+	}
+}
+
+void Graphics::Renderer::rebindTextures() {
+	for (auto& layer : this->layers) {
+		for (auto& [zIndex, objects] : layer->objs) {
+			for (auto object : objects) {
+				ObjectConfig* config = object->getConfig();
+				CustomTexture* texture = Graphics::getTexture(config->textureHandle);
+				if (!config->texture || !texture) {
+					continue;
+				}
+				config->texture->setTexture(*texture->texture);
+				config->texture->setTextureRect(texture->rect);
+				// the real texture is rarely the placeholder's size
+				object->textureBound();
+				object->markMoved();
+			}
+		}
+		// objects shared between layers, like the menu background, only dirty the layer they were built on
+		layer->markDirty();
+	}
+	this->requestRedraw();
+}
+
+int32_t Graphics::HitGrid::cellOf(float coordinate) {
+	return (int32_t)std::floor(coordinate / cellSize);
+}
+
+uint64_t Graphics::HitGrid::key(int32_t x, int32_t y) {
+	return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+template <typename Visit>
+void Graphics::HitGrid::forEachCell(const sf::FloatRect& bounds, Visit&& visit) {
+	const int32_t left = cellOf(bounds.position.x);
+	const int32_t top = cellOf(bounds.position.y);
+	const int32_t right = cellOf(bounds.position.x + bounds.size.x);
+	const int32_t bottom = cellOf(bounds.position.y + bounds.size.y);
+	for (int32_t y = top; y <= bottom; y++) {
+		for (int32_t x = left; x <= right; x++) {
+			visit(this->cells[key(x, y)]);
+		}
+	}
+}
+
+void Graphics::HitGrid::link(const Entry& entry) {
+	this->forEachCell(entry.bounds, [&entry](std::vector<Entry>& cell) {
+		cell.push_back(entry);
+	});
+}
+
+void Graphics::HitGrid::unlink(const Entry& entry) {
+	this->forEachCell(entry.bounds, [&entry](std::vector<Entry>& cell) {
+		for (size_t i = 0; i < cell.size(); i++) {
+			if (cell[i].object == entry.object) {
+				cell[i] = cell.back();
+				cell.pop_back();
+				break;
+			}
+		}
+	});
+}
+
+void Graphics::HitGrid::insert(Object* object, uint32_t order) {
+	if (!object->getConfig()->texture || this->entries.count(object)) {
+		return;
+	}
+	Entry entry = { object, object->getConfig()->texture->getGlobalBounds(), order };
+	this->entries.emplace(object, entry);
+	this->link(entry);
+}
+
+void Graphics::HitGrid::update(Object* object) {
+	auto it = this->entries.find(object);
+	if (it == this->entries.end()) {
+		return;
+	}
+	const sf::FloatRect bounds = object->getConfig()->texture->getGlobalBounds();
+	if (bounds == it->second.bounds) {
+		return;
+	}
+	this->unlink(it->second);
+	it->second.bounds = bounds;
+	this->link(it->second);
+}
+
+Graphics::Object* Graphics::HitGrid::at(sf::Vector2f point) const {
+	auto cell = this->cells.find(key(cellOf(point.x), cellOf(point.y)));
+	if (cell == this->cells.end()) {
+		return nullptr;
+	}
+	const Entry* best = nullptr;
+	for (auto& entry : cell->second) {
+		if ((!best || entry.order > best->order) && entry.bounds.contains(point) && entry.object->isVisible()) {
+			best = &entry;
+		}
+	}
+	return best ? best->object : nullptr;
+}
+
 void Graphics::Layer::addObject(Graphics::Object* obj) {
 	if (obj) {
 		this->objs[obj->getConfig()->zIndex].emplace_back(obj);
+		// higher z-index first, then whatever was added later, the same order things are drawn in
+		this->hitGrid.insert(obj, ((uint32_t)obj->getConfig()->zIndex << 24) | (this->addedObjects++ & 0xFFFFFF));
+		this->markDirty();
 		DEBUG(obj->getConfig()->name << " was added to " << this->name);
 	}
 }
 
+void Graphics::Layer::clear() {
+	this->objs.clear();
+	this->batches.clear();
+	this->hitGrid.clear();
+	this->addedObjects = 0;
+	this->arena.reset();
+	this->markDirty();
+}
+
+void Graphics::HitGrid::clear() {
+	this->cells.clear();
+	this->entries.clear();
+}
+
 void Graphics::Layer::print() {
-	DEBUG("Printing " << this->name << " layer's elements:");
+	DEBUG("Printing " << this->name << " layer's elements (" << this->arena.getAllocations() << " allocations, "
+		<< this->arena.getBytes() << " bytes in " << this->arena.getBlockCount() << " blocks):");
 	for (auto& e : this->objs) {
 		for (auto& l : e.second) {
 			DEBUG("\t" << l->getConfig()->name);
@@ -670,9 +1691,11 @@ void Graphics::Layer::print() {
 inline void Graphics::Button::setPosition(float x, float y) {
 	this->config->texture->setPosition({ x,y });
 	this->config->text->setPosition({ x,y });
+	this->markMoved();
 }
 
 inline void Graphics::Button::setOrigin(float x, float y) {
 	this->config->texture->setOrigin({ x, y });
 	this->config->text->setOrigin({ x, y });
-}
\ No newline at end of file
+	this->markMoved();
+}
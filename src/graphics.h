@@ -1,6 +1,10 @@
 #pragma once
 
 #include "settings.h"
+#include "arena.h"
+#include <unordered_map>
+#include <string_view>
+#include <tuple>
 
 namespace LayoutDesign {
 	constexpr uint8_t top = 0;
@@ -21,30 +25,60 @@ namespace LayoutDesign {
 	constexpr uint8_t global_scaleY = 6;
 
 	constexpr uint8_t description_size = 25;
+	constexpr float slot_spacing = 60.f;
+	constexpr float thumbnail_x = 64.f;
+}
+
+namespace Atlas {
+	struct Atlas;
+}
+
+namespace Graphics {
+	// slot of a texture in the registry, stays the same until the texture is unloaded
+	using TextureHandle = uint16_t;
+	constexpr TextureHandle noTexture = UINT16_MAX;
 }
 
 namespace TextureNames {
-	const std::string button = "button";
-	const std::string dropdownBar = "dropdown_bar";
-	const std::string inputBar = "input_bar";
-	const std::string mainBG = "main_background_single_color";
+	// textures the code asks for by name, their slots are reserved up front in this order
+	constexpr std::string_view builtin[] = { "button", "dropdown_bar", "input_bar", "main_background_single_color" };
+
+	constexpr Graphics::TextureHandle handleOf(std::string_view name) {
+		for (size_t i = 0; i < std::size(builtin); i++) {
+			if (builtin[i] == name) {
+				return (Graphics::TextureHandle)i;
+			}
+		}
+		return Graphics::noTexture;
+	}
+
+	constexpr Graphics::TextureHandle button = handleOf("button");
+	constexpr Graphics::TextureHandle dropdownBar = handleOf("dropdown_bar");
+	constexpr Graphics::TextureHandle inputBar = handleOf("input_bar");
+	constexpr Graphics::TextureHandle mainBG = handleOf("main_background_single_color");
 }
 
 namespace Graphics {
 	class Layer;
-	class DropdownElement;
 	class DropdownBar;
+	class ScrollList;
 
 	struct ObjectConfig {
 		sf::Sprite* texture;
+		// the registry texture the sprite shows, held until the config is destroyed
+		TextureHandle textureHandle;
 		std::string name;
 		std::function<void()> handler;
 		uint8_t zIndex;
 		Layer* layer;
+		// what withTextureOrigin divides the texture's size by, 0 while it wasn't called
+		sf::Vector2f originDivisor;
 
-		ObjectConfig() : zIndex(1), layer(nullptr), handler(nullptr), name("sadsadasdsa"), texture(nullptr) { DEBUG("obj config"); }
+		ObjectConfig() : zIndex(1), layer(nullptr), handler(nullptr), name("sadsadasdsa"), texture(nullptr), textureHandle(noTexture), originDivisor({ 0.f, 0.f }) { DEBUG("obj config"); }
 		ObjectConfig(sf::Sprite* t, const std::string n, std::function<void()> h, uint8_t zI, Layer* l) :
-			texture(t), name(n), handler(h), zIndex(zI), layer(l) {}
+			texture(t), textureHandle(noTexture), name(n), handler(h), zIndex(zI), layer(l), originDivisor({ 0.f, 0.f }) {}
+		ObjectConfig(const ObjectConfig&) = delete;
+		~ObjectConfig();
 	};
 
 	struct BackgroundConfig : public ObjectConfig {
@@ -63,42 +97,267 @@ namespace Graphics {
 		InputBoxConfig() : ButtonConfig() {}
 	};
 
-	struct DropdownElementConfig : public ButtonConfig {
-		DropdownBar* parent;
-
-		DropdownElementConfig() : ButtonConfig(), parent(nullptr) {}
+	struct ScrollListConfig : public ObjectConfig {
+		// the data source, only asked about the items that scroll into view, by item and column
+		std::function<size_t()> itemCount;
+		std::function<std::string(size_t, size_t)> itemText;
+		std::function<void(size_t)> onSelect;
+		// the texture is stretched over the viewport
+		sf::Vector2f size;
+		float rowHeight;
+		// one column across the whole width when empty
+		std::vector<float> columnWidths;
+		// space at the top the rows don't scroll into
+		float headerHeight;
+
+		ScrollListConfig() : ObjectConfig(), itemCount(nullptr), itemText(nullptr), onSelect(nullptr), size({ 200.f, 200.f }), rowHeight(32.f),
+			columnWidths({}), headerHeight(0.f) {}
 	};
 
 	struct DropdownBarConfig : public ButtonConfig {
-		std::vector<DropdownElement*> contents;
+		std::vector<std::string> items;
+		ScrollList* list;
 
-		DropdownBarConfig() : ButtonConfig(), contents({}) {}
+		DropdownBarConfig() : ButtonConfig(), items({}), list(nullptr) {}
 	};
 
 
+	/*
+	* Glyph quads of one string in one font and size, laid out the way sf::Text does but in the
+	* text's local space, so every text showing that string can reuse them under its own
+	* transform and colour. Characters can be appended or erased at the end without laying
+	* out the rest again.
+	*/
+	class TextLayout {
+	public:
+		struct Quad {
+			float left, top, right, bottom;
+			float u1, v1, u2, v2;
+		};
+	private:
+		// pen and bounds before each character, erasing one goes back to them
+		struct Step {
+			float x, y;
+			char32_t previous;
+			size_t quads;
+			float minX, minY, maxX, maxY;
+		};
+
+		const sf::Font* font;
+		unsigned int size;
+		bool bold;
+		float letterSpacingFactor;
+		float lineSpacingFactor;
+		float whitespaceWidth;
+		float letterSpacing;
+		float lineSpacing;
+
+		std::vector<Quad> quads;
+		std::vector<Step> steps;
+		float x, y;
+		char32_t previous;
+		float minX, minY, maxX, maxY;
+	public:
+		TextLayout() : font(nullptr), size(0), bold(false), letterSpacingFactor(1.f), lineSpacingFactor(1.f), whitespaceWidth(0.f),
+			letterSpacing(0.f), lineSpacing(0.f), quads({}), steps({}), x(0.f), y(0.f), previous(0), minX(0.f), minY(0.f), maxX(0.f), maxY(0.f) {}
+		TextLayout(const sf::Font& font, unsigned int size, bool bold, float letterSpacingFactor, float lineSpacingFactor);
+
+		// laid out with the text's font, size and spacing
+		static TextLayout of(const sf::Text& text);
+
+		void append(char32_t character);
+		// removes the last character
+		void erase();
+		void clear();
+
+		// whether the text is drawn with the font, size and spacing this was laid out for
+		bool matches(const sf::Text& text) const;
+		size_t length() const { return this->steps.size(); }
+		const std::vector<Quad>& getQuads() const { return this->quads; }
+		const sf::Texture& getTexture() const { return this->font->getTexture(this->size); }
+		// what sf::Text::getLocalBounds gives for the same string, without italics
+		sf::FloatRect getBounds() const;
+	};
+
+	/*
+	* Layouts by font, size, spacing and string. Lookups view the text's own string, so a hit
+	* costs a hash and allocates nothing. The cache is dropped whole once it holds maxLayouts.
+	*/
+	class TextLayoutCache {
+	private:
+		struct Style {
+			const sf::Font* font;
+			unsigned int size;
+			bool bold;
+			float letterSpacing;
+			float lineSpacing;
+
+			bool operator<(const Style& other) const {
+				return std::tie(font, size, bold, letterSpacing, lineSpacing) < std::tie(other.font, other.size, other.bold, other.letterSpacing, other.lineSpacing);
+			}
+		};
+
+		struct StringHash {
+			using is_transparent = void;
+			size_t operator()(std::u32string_view string) const { return std::hash<std::u32string_view>()(string); }
+		};
+
+		std::map<Style, std::unordered_map<std::u32string, TextLayout, StringHash, std::equal_to<>>> layouts;
+		size_t count;
+		size_t hits;
+		size_t misses;
+	public:
+		static constexpr size_t maxLayouts = 8192;
+
+		TextLayoutCache() : layouts({}), count(0), hits(0), misses(0) {}
+
+		// valid until the next get
+		const TextLayout& get(const sf::Text& text);
+		// has to be called before a font the cache has seen is deleted
+		void clear();
+		size_t getHits() const { return this->hits; }
+		size_t getMisses() const { return this->misses; }
+	};
+
+	/*
+	* Quads of one z-index of a layer, grouped by texture so every group is one draw call.
+	* Sprites go before text, which keeps a label above its own button. Objects that overlap
+	* other objects of the same z-index need a z-index of their own. Text comes from the layout
+	* cache as quads on the font's glyph page, text with an outline or lines is drawn on its own.
+	*/
+	class SpriteBatch {
+	private:
+		struct Group {
+			const sf::Texture* texture;
+			sf::VertexArray vertices;
+
+			Group(const sf::Texture* texture) : texture(texture), vertices(sf::PrimitiveType::Triangles) {}
+		};
+
+		std::vector<Group> sprites;
+		std::vector<Group> glyphs;
+		std::vector<const sf::Text*> unbatched;
+
+		sf::VertexArray& groupFor(std::vector<Group>& groups, const sf::Texture* texture);
+	public:
+		SpriteBatch() : sprites({}), glyphs({}), unbatched({}) {}
+
+		void clear();
+		void add(const sf::Sprite& sprite);
+		void add(const sf::Text& text);
+		// the text's transform and colour over a layout of its string
+		void add(const TextLayout& layout, const sf::Text& text);
+		size_t quadCount() const;
+		// returns how many draw calls it took
+		uint32_t draw(sf::RenderTarget& target);
+	};
+
+	// a texture's place on its atlas page
 	class CustomTexture {
 	public:
 		std::string name;
-		sf::Texture* texture;
+		const sf::Texture* texture;
+		uint32_t page;
+		sf::IntRect rect;
 
-		CustomTexture(const std::string& name, sf::Texture* tex);
+		CustomTexture(const std::string& name, const sf::Texture* texture, uint32_t page, const sf::IntRect& rect);
 		~CustomTexture() = default;
 	};
 
+	/*
+	* Interns texture names into handles when they're loaded, so looking one up is an index
+	* instead of a search. Names are the file names without the extension, builtin ones keep
+	* their slots from TextureNames. Every texture is counted: loading holds one reference,
+	* each config showing it another. Once the last one goes the texture is freed, and so is
+	* its atlas page when nothing on it is left.
+	*/
+	class TextureRegistry {
+	private:
+		struct Slot {
+			std::string name;
+			CustomTexture* texture;
+			uint32_t refs;
+		};
+
+		struct NameHash {
+			using is_transparent = void;
+			size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+		};
+
+		std::vector<Slot> slots;
+		std::unordered_map<std::string, TextureHandle, NameHash, std::equal_to<>> handles;
+		std::vector<TextureHandle> freeSlots;
+		// textures still alive on each atlas page
+		std::vector<uint32_t> pageRefs;
+		size_t loaded;
+
+		void free(TextureHandle handle);
+		// unbinds the name so the slot can be handed out again
+		void recycle(TextureHandle handle);
+	public:
+		TextureRegistry();
+
+		// takes ownership of the texture, the registry holds the loading reference
+		TextureHandle add(std::string_view name, CustomTexture* texture);
+
+		// the slot bound to the name, loaded or not, a new empty one that add fills in later if there's none
+		TextureHandle reserve(std::string_view name);
+		// noTexture when nothing of the name is loaded
+		TextureHandle find(std::string_view name) const;
+		CustomTexture* get(TextureHandle handle) const {
+			return handle < this->slots.size() ? this->slots[handle].texture : nullptr;
+		}
+
+		void acquire(TextureHandle handle);
+		void release(TextureHandle handle);
+		// drops the loading reference, the texture goes once nothing shows it anymore
+		void unload(TextureHandle handle) { this->release(handle); }
+
+		// frees every texture regardless of references, builtin slots stay reserved
+		void clear();
+		bool empty() const;
+		size_t size() const;
+	};
+
+	enum ObjectKind : uint8_t {
+		BACKGROUND,
+		BUTTON,
+		INPUT_BOX,
+		SCROLL_LIST,
+		DROPDOWN_BAR
+	};
+
+	// what input an object takes, the input handlers route on these instead of on its type
+	enum Capability : uint8_t {
+		HOVERABLE = 1 << 0,
+		FOCUSABLE = 1 << 1,
+		TEXT_INPUT = 1 << 2,
+		SCROLLABLE = 1 << 3
+	};
+
 	class Object {
 	private:
 		ObjectConfig* config;
+	protected:
+		ObjectKind kind;
+		uint8_t capabilities;
+
+		// every constructor down the hierarchy sets its own, the most derived one wins
+		void setKind(ObjectKind kind, uint8_t capabilities) { this->kind = kind; this->capabilities = capabilities; }
 	public:
 
-		Object() { config = new ObjectConfig(); }
 		Object(ObjectConfig* config);
 		~Object() = default;
 
+		ObjectKind getKind() const { return this->kind; }
+		bool has(Capability capability) const { return (this->capabilities & capability) != 0; }
+
 		inline virtual ObjectConfig* getConfig();
 		inline virtual void onPress() = 0;
 		inline virtual void onFocusLoss() = 0;
 		inline virtual void render(sf::RenderWindow*) = 0;
-		inline bool isVisible() const;
+		inline virtual void batch(SpriteBatch& batch) = 0;
+		bool isVisible() const;
 		inline bool contains(float x, float y) const;
 		inline void hide();
 		inline void reveal();
@@ -106,6 +365,16 @@ namespace Graphics {
 		inline void onHoverLoss();
 		inline void changePos(float x, float y);
 		inline void move(float x, float y);
+		// a step of whatever the object does over time, the renderer calls it before every frame
+		// after startAnimating until it returns false
+		virtual bool animate(float) { return false; }
+		// the renderer swapped the placeholder for the real texture, anything laid out against
+		// the texture's size is done again
+		virtual void textureBound();
+		// anything that changes how the object looks calls this, so its layer is drawn again
+		void markDirty();
+		// like markDirty, for changes to where the object is, which hit testing has to know about too
+		void markMoved();
 	};
 
 	class Button : public Object {
@@ -113,7 +382,6 @@ namespace Graphics {
 		ButtonConfig* config;
 	public:
 
-		Button() : Object() {}
 		Button(ButtonConfig* config);
 		~Button() = default;
 
@@ -123,6 +391,7 @@ namespace Graphics {
 		void onPress() override;
 		void onFocusLoss() override {};
 		void render(sf::RenderWindow* window) override;
+		void batch(SpriteBatch& batch) override;
 		inline void changePos(float x, float y);
 		inline void move(float x, float y);
 		inline void hide();
@@ -142,6 +411,7 @@ namespace Graphics {
 		inline void onPress() override {}
 		inline void onFocusLoss() override {};
 		void render(sf::RenderWindow* window) override;
+		void batch(SpriteBatch& batch) override;
 		inline void onHover() {}
 		inline void onHoverLoss() {}
 	};
@@ -149,6 +419,10 @@ namespace Graphics {
 	class InputBox : public Button {
 	private:
 		InputBoxConfig* config;
+		// follows the text a key at a time instead of laying it out again
+		TextLayout layout;
+
+		void syncLayout();
 	public:
 
 		InputBox(InputBoxConfig* config);
@@ -157,104 +431,176 @@ namespace Graphics {
 		inline void changeConfig(InputBoxConfig* config);
 		inline InputBoxConfig* getConfig() override;
 		void render(sf::RenderWindow* window) override;
+		void batch(SpriteBatch& batch) override;
 		void onPress() override;
 		void onFocusLoss() override;
 		void changeText(const char& newChar = {}, bool removeChar = false);
 	};
 
-	class DropdownElement : public Button {
+	/*
+	* A list over a data source of any length that only has rows for what fits in its viewport,
+	* plus overscan above and below. Item i always goes to row i % rows, so scrolling by a row
+	* rebinds the one row that went out of view and the data source is asked for that one item.
+	* The wheel moves a target offset the list eases towards over the next frames, rows cut by
+	* the viewport's edge are cropped and their text is left out.
+	*/
+	class ScrollList : public Object {
 	private:
-		DropdownElementConfig* config;
+		struct Row {
+			sf::Sprite* background;
+			// one per column
+			std::vector<sf::Text*> cells;
+			// SIZE_MAX while nothing is bound
+			size_t item;
+			bool visible;
+			bool textVisible;
+		};
+
+		ScrollListConfig* config;
+		std::vector<Row> rows;
+		float offset;
+		float targetOffset;
+
+		float maxOffset() const;
+		// stretches the texture over the viewport again, it may have been swapped for one of another size
+		void fitFrame();
+		void layoutRows();
+	protected:
+		// where the rows scroll, the texture's bounds without the header
+		sf::FloatRect viewport() const;
+		// left edge of the column relative to the list
+		float columnStart(size_t column) const;
+		size_t columnCount() const { return std::max<size_t>(1, this->config->columnWidths.size()); }
 	public:
+		static constexpr size_t overscan = 2;
+		static constexpr float wheelRows = 3.f;
+		// how quickly the offset closes in on its target, per second
+		static constexpr float scrollEase = 18.f;
 
-		DropdownElement(DropdownElementConfig* config);
-		
-		inline void changeConfig(DropdownElementConfig* config);
-		inline DropdownElementConfig* getConfig() override;
-		inline void render(sf::RenderWindow*) override {};
-		inline void onFocusLoss() override {};
+		// the rows are made in the same arena as the list
+		ScrollList(ScrollListConfig* config, Memory::Arena& arena);
+
+		ScrollListConfig* getConfig() override;
+		void render(sf::RenderWindow* window) override;
+		void batch(SpriteBatch& batch) override;
+		// picks the item under the mouse
+		void onPress() override;
+		void onFocusLoss() override {}
+		void textureBound() override;
+
+		// the viewport is cut to as many rows as the list was made with
+		void place(float x, float y, float width, float height, float rowHeight);
+		void scroll(float wheelDelta);
+		void scrollTo(size_t item);
+		// eases towards the target offset, false once it got there
+		bool animate(float seconds) override;
+		// binds every row again, for when the data source changed
+		void refresh();
+		// SIZE_MAX when no item is under the point
+		size_t itemAt(sf::Vector2f point) const;
 	};
 
 	class DropdownBar : public Button {
 	private:
-		enum Direction {
-			UP = -1,
-			DOWN = 1
-		};
 		DropdownBarConfig* config;
 
+		// puts the list right below the bar, sized by the bar's texture
+		void placeList();
+
 	public:
+		static constexpr uint32_t visibleItems = 6;
+
 		DropdownBar(DropdownBarConfig* config);
-		~DropdownBar();
 
 		inline void changeConfig(DropdownBarConfig* config);
 		inline DropdownBarConfig* getConfig();
 
 		void render(sf::RenderWindow* window) override;
+		void batch(SpriteBatch& batch) override;
+		// opens or closes the list
 		void onPress() override;
 		void onFocusLoss() override;
-		//void onScroll(bool up);
-		//void createContentList(const std::vector<std::string>& contentList);
-		//void moveContents(Direction direction);
+		void textureBound() override;
+		void select(size_t item);
 	};
 
+	/*
+	* Builders make the config, sprite, text and the object itself in the arena they're given,
+	* usually the one of the layer the object ends up on, so clearing that layer frees them.
+	* Derived builders share one config with their bases, and a builder builds one object.
+	*/
 	class ObjectBuilder {
 	private:
 		ObjectConfig* config;
-	public:
+	protected:
+		Memory::Arena& arena;
 
-		ObjectBuilder();
-		inline virtual ObjectBuilder& withTexture(const std::string& textureName);
-		inline virtual ObjectBuilder& withName(const std::string& name);
-		inline virtual ObjectBuilder& withHandler(std::function<void()> handler);
-		inline virtual ObjectBuilder& withZIndex(uint8_t renderLayer);
-		inline virtual ObjectBuilder& withLayer(Layer* layer);
-		inline virtual ObjectBuilder& withTextureScale(float x, float y);
-		inline virtual ObjectBuilder& withTexturePos(float x, float y);
-		inline virtual ObjectBuilder& withTexturePosOffset(float x, float y);
-		inline virtual ObjectBuilder& withTextureOrigin(float x, float y);
+		ObjectBuilder(Memory::Arena& arena, ObjectConfig* config);
+	public:
+		virtual ObjectBuilder& withTexture(TextureHandle handle);
+		virtual ObjectBuilder& withTexture(std::string_view textureName);
+		virtual ObjectBuilder& withName(const std::string& name);
+		virtual ObjectBuilder& withHandler(std::function<void()> handler);
+		virtual ObjectBuilder& withZIndex(uint8_t renderLayer);
+		virtual ObjectBuilder& withLayer(Layer* layer);
+		virtual ObjectBuilder& withTextureScale(float x, float y);
+		virtual ObjectBuilder& withTexturePos(float x, float y);
+		virtual ObjectBuilder& withTexturePosOffset(float x, float y);
+		virtual ObjectBuilder& withTextureOrigin(float x, float y);
 		inline virtual Object* build() = 0;
 	};
 
 	class BackgroundBuilder : public ObjectBuilder {
 	private:
 		BackgroundConfig* config;
+
+		BackgroundBuilder(Memory::Arena& arena, BackgroundConfig* config) : ObjectBuilder(arena, config), config(config) {}
 	public:
 
-		BackgroundBuilder() : ObjectBuilder() { config = new BackgroundConfig(); }
+		BackgroundBuilder(Memory::Arena& arena) : BackgroundBuilder(arena, arena.make<BackgroundConfig>()) {}
 		Background* build() override;
 	};
 
 	class ButtonBuilder : public ObjectBuilder {
 	private:
 		ButtonConfig* config;
+	protected:
+		ButtonBuilder(Memory::Arena& arena, ButtonConfig* config) : ObjectBuilder(arena, config), config(config) {}
 	public:
 
-		ButtonBuilder() : ObjectBuilder() { config = new ButtonConfig(); }
-		inline ButtonBuilder& withText(const std::string& text);
-		inline ButtonBuilder& withTextPos(float x, float y);
-		inline ButtonBuilder& withTextPosOffest(float x, float y);
-		inline ButtonBuilder& withTextOrigin(float x, float y);
-		inline ButtonBuilder& withTextScale(float x, float y);
+		ButtonBuilder(Memory::Arena& arena) : ButtonBuilder(arena, arena.make<ButtonConfig>()) {}
+		ButtonBuilder& withText(const std::string& text);
+		ButtonBuilder& withTextPos(float x, float y);
+		ButtonBuilder& withTextPosOffest(float x, float y);
+		ButtonBuilder& withTextOrigin(float x, float y);
+		ButtonBuilder& withTextScale(float x, float y);
 		Button* build() override;
 	};
 
-	class DropdownElementBuilder : public ButtonBuilder {
+	class ScrollListBuilder : public ObjectBuilder {
 	private:
-		DropdownElementConfig* config;
+		ScrollListConfig* config;
+	protected:
+		ScrollListBuilder(Memory::Arena& arena, ScrollListConfig* config) : ObjectBuilder(arena, config), config(config) {}
 	public:
 
-		DropdownElementBuilder() : ButtonBuilder() { config = new DropdownElementConfig(); };
-		inline DropdownElementBuilder& withParent(DropdownBar* bar);
-		DropdownElement* build() override;
+		ScrollListBuilder(Memory::Arena& arena) : ScrollListBuilder(arena, arena.make<ScrollListConfig>()) {}
+		ScrollListBuilder& withSource(std::function<size_t()> itemCount, std::function<std::string(size_t, size_t)> itemText);
+		ScrollListBuilder& withColumns(const std::vector<float>& widths, float headerHeight);
+		ScrollListBuilder& withSelect(std::function<void(size_t)> onSelect);
+		ScrollListBuilder& withSize(float width, float height);
+		ScrollListBuilder& withRowHeight(float rowHeight);
+		ScrollList* build() override;
 	};
 
 	class DropdownBarBuilder : public ButtonBuilder {
 	private:
 		DropdownBarConfig* config;
+
+		DropdownBarBuilder(Memory::Arena& arena, DropdownBarConfig* config) : ButtonBuilder(arena, config), config(config) {}
 	public:
 
-		DropdownBarBuilder() : ButtonBuilder() { config = new DropdownBarConfig(); };
+		DropdownBarBuilder(Memory::Arena& arena) : DropdownBarBuilder(arena, arena.make<DropdownBarConfig>()) {}
 		inline DropdownBarBuilder& withContents(const std::vector<std::string>& texts);
 		DropdownBar* build() override;
 	};
@@ -262,13 +608,55 @@ namespace Graphics {
 	class InputBoxBuilder : public ButtonBuilder {
 	private:
 		InputBoxConfig* config;
+
+		InputBoxBuilder(Memory::Arena& arena, InputBoxConfig* config) : ButtonBuilder(arena, config), config(config) {}
 	public:
 
-		InputBoxBuilder() : ButtonBuilder() { config = new InputBoxConfig(); }
+		InputBoxBuilder(Memory::Arena& arena) : InputBoxBuilder(arena, arena.make<InputBoxConfig>()) {}
 		InputBox* build() override;
 	};
 
 
+	/*
+	* Uniform grid over the bounds of a layer's objects for hit testing. An object is listed in
+	* every cell its bounds touch together with its draw order, so the topmost object under a
+	* point is found among the few entries of a single cell. Visibility is checked when asked,
+	* so only moves have to update the grid.
+	*/
+	class HitGrid {
+	private:
+		struct Entry {
+			Object* object;
+			sf::FloatRect bounds;
+			uint32_t order;
+		};
+
+		static constexpr float cellSize = 64.f;
+		std::unordered_map<uint64_t, std::vector<Entry>> cells;
+		std::unordered_map<Object*, Entry> entries;
+
+		static int32_t cellOf(float coordinate);
+		static uint64_t key(int32_t x, int32_t y);
+		template <typename Visit>
+		void forEachCell(const sf::FloatRect& bounds, Visit&& visit);
+		void link(const Entry& entry);
+		void unlink(const Entry& entry);
+	public:
+		HitGrid() : cells({}), entries({}) {}
+
+		void clear();
+
+		void insert(Object* object, uint32_t order);
+		// re-reads the object's bounds, does nothing for objects that aren't in the grid
+		void update(Object* object);
+		Object* at(sf::Vector2f point) const;
+	};
+
+	/*
+	* A layer is only rebuilt when it's continuous or something on it changed since its last
+	* frame, otherwise its batches from that frame are drawn again. Code that edits an object's
+	* sprite or text directly instead of through Object has to call markDirty itself.
+	*/
 	class Layer {
 	public:
 		std::string name;
@@ -276,14 +664,25 @@ namespace Graphics {
 		bool alreadyRendered;
 		uint8_t outerRenderLayer;
 		std::map<uint8_t, std::vector<Graphics::Object*>> objs;
+		// one per z-index, refilled every frame but the vertex storage is kept
+		std::map<uint8_t, SpriteBatch> batches;
+		HitGrid hitGrid;
+		uint32_t addedObjects;
+		// owns everything built for this layer
+		Memory::Arena arena;
 
 		Layer() = default;
-		Layer(const std::string& name, bool continuousRendering, uint8_t outerRenderLayer) : name(name), continuousRendering(continuousRendering), alreadyRendered(false), outerRenderLayer(outerRenderLayer) 
+		Layer(const std::string& name, bool continuousRendering, uint8_t outerRenderLayer) : name(name), continuousRendering(continuousRendering), alreadyRendered(false), outerRenderLayer(outerRenderLayer), addedObjects(0)
 		{ objs = std::map<uint8_t, std::vector<Graphics::Object*>>(); }
 
-		void onRender(sf::RenderWindow& window);
+		void markDirty() { this->alreadyRendered = false; }
+		bool needsRender() const { return this->continuousRendering || !this->alreadyRendered; }
+		// returns how many draw calls the layer took
+		uint32_t onRender(sf::RenderWindow& window);
 
 		void addObject(Graphics::Object* obj);
+		// destroys everything built in the layer's arena and empties it for the next build
+		void clear();
 		void print();
 	};
 
@@ -314,11 +713,19 @@ namespace Graphics {
 		Graphics::Object* prevClickedObject;
 		
 		bool inputBoxActive;
+		// draw calls of the last frame, shown in the corner while showFrameStats is on (F3)
+		uint32_t drawCalls;
+		bool showFrameStats;
+		// set by anything that changes the whole frame, like revealing a layer or a resize
+		bool redrawRequested;
 		const uint8_t innerLayerCount;
 		const uint8_t outerLayerCount;
 		
 		std::map<uint8_t, Layer*> onScreenLayers;
 		std::vector<Layer*> layers;
+		// objects still doing something over time, stepped before every frame
+		std::vector<Object*> animating;
+		sf::Clock animationClock;
 
 		static Renderer* getRender() {
 			if (!instance) {
@@ -327,7 +734,10 @@ namespace Graphics {
 			return instance;
 		}
 
-		void refreshFrame();
+		void requestRedraw() { this->redrawRequested = true; }
+		bool needsFrame() const;
+		// draws and presents a frame if anything on screen changed, returns whether it did
+		bool refreshFrame();
 		void hideLayer(Layer* layer);
 		void hideLayer(const std::string& name);
 		void revealLayer(Layer* layer);
@@ -341,22 +751,44 @@ namespace Graphics {
 		void handleKeyPress(std::optional<sf::Event> event);
 		void handleScroll(std::optional<sf::Event> event);
 
+		// the topmost visible object under the point, layers with a higher outer render layer come first
 		Graphics::Object* getTargetObject(const sf::Vector2f& mousePos, std::map<uint8_t, Graphics::Layer*>* list);
 		Graphics::Object* getTargetObject(const std::string& name, std::map<uint8_t, Graphics::Layer*>* list);
 
-		void deleteVector(const std::map<uint8_t, std::vector<Graphics::Object*>>& vector);
+		void objectMoved(Graphics::Object* object);
+		// keeps frames coming while the object animates, like a list easing to where it was scrolled
+		void startAnimating(Object* object);
+		void stopAnimating(Layer* layer);
+		// points every sprite at what its texture handle resolves to now, for textures that arrived after the build
+		void rebindTextures();
+		// tears the layer's screen down, nothing it built may be used afterwards
+		void clearLayer(const std::string& name);
 	};
 
-	sf::Texture* getTexture(const std::string& name);
+	// the placeholder while textures are still loading or when the handle has none
+	Graphics::CustomTexture* getTexture(TextureHandle handle);
+	Graphics::CustomTexture* getTexture(std::string_view name);
 	Graphics::Object* getObjectByCords(float x, float y, std::vector<Graphics::Object*> onScreenObjs);
 	sf::Font* useMainFont();
 	void loadMainFont();
+	std::filesystem::path mainFontPath();
+	// loads and uploads everything at once, Assets::Loader does the same a slice at a time
 	void loadTextures();
+	std::vector<std::filesystem::path> textureSources();
+	// registers the atlas' entries on the already uploaded pages, one texture per atlas page
+	void addAtlas(const Atlas::Atlas& atlas, const std::vector<sf::Texture*>& pages);
+	void createPlaceholderTexture();
+	// uploads an image that isn't part of the atlas as a page of its own, it goes with its last user
+	TextureHandle addImageTexture(const std::string& name, const sf::Image& image);
 
 	void deloadTextures();
 	void deloadFont();
 
 	extern sf::Font* mainFont;
-	extern std::vector<Graphics::CustomTexture*> textures;
+	extern TextureRegistry textures;
+	extern TextLayoutCache textLayouts;
+	extern std::vector<sf::Texture*> atlasPages;
+	// shown by sprites whose texture isn't loaded (yet)
+	extern CustomTexture* placeholderTexture;
 	extern unsigned int currentID;
 }
\ No newline at end of file
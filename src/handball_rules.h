@@ -0,0 +1,42 @@
+#pragma once
+
+#include "sport_kernel.h"
+
+namespace Rules {
+	// 2 x 30 minutes, ~55 possessions per side, rolling substitutions and 2 minute suspensions
+	struct Handball {
+		static constexpr uint32_t matchSeconds = 60 * 60;
+		static constexpr uint8_t periods = 2;
+		static constexpr float meanPossessionSeconds = 32.f;
+		static constexpr uint32_t minPossessionSeconds = 8;
+
+		static constexpr float shotChance = 0.8f;
+		static constexpr float conversion = 0.58f;
+		static constexpr float ratingSwing = 0.5f;
+		static constexpr float homeAdvantage = 0.03f;
+		static constexpr uint16_t pointsPerScore = 1;
+		static constexpr uint16_t pointsForWin = 2;
+		static constexpr uint16_t pointsForDraw = 1;
+
+		static constexpr float fatiguePerPossession = 0.005f;
+		static constexpr float periodRecovery = 0.1f;
+
+		static constexpr bool rollingSubstitutions = true;
+		static constexpr uint8_t maxSubstitutions = 0;
+		static constexpr float substitutionThreshold = 0.85f;
+		static constexpr float substitutionRecovery = 0.1f;
+
+		static constexpr float suspensionChance = 0.04f;
+		static constexpr uint32_t suspensionSeconds = 2 * 60;
+		static constexpr float shorthandedPenalty = 0.15f;
+	};
+}
+
+namespace Match {
+	template <>
+	struct RulesFor<Modes::HANDBALL> {
+		using type = Rules::Handball;
+	};
+
+	using HandballKernel = ContinuousKernel<Rules::Handball>;
+}
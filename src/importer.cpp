@@ -0,0 +1,609 @@
+#include "importer.h"
+#include "thread_pool.h"
+#include "logging.h"
+#include "../include/json.hpp"
+#include <fstream>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace Import {
+	constexpr uint16_t noClub = UINT16_MAX;
+
+	enum Field : uint8_t {
+		NAME,
+		PERSONALITY,
+		CLUB,
+		EMOTIONS,
+		MOTIVATIONS,
+		MORALITIES,
+		INTELLIGENCE,
+		BACKGROUND,
+		UNKNOWN_FIELD
+	};
+
+	static Field fieldOf(const std::string& key) {
+		if (key == "name") return NAME;
+		else if (key == "personality") return PERSONALITY;
+		else if (key == "club") return CLUB;
+		else if (key == "emotions") return EMOTIONS;
+		else if (key == "motivations") return MOTIVATIONS;
+		else if (key == "moralities") return MORALITIES;
+		else if (key == "intelligence") return INTELLIGENCE;
+		else if (key == "background") return BACKGROUND;
+		else return UNKNOWN_FIELD;
+	}
+
+	// bit of a trait in the packed bitset, -1 when the value isn't a trait of that category
+	static int traitBit(Field field, const std::string& value) {
+		switch (field) {
+		case EMOTIONS: {
+			auto e = Traits::stringToEmotion(value);
+			return e == Traits::EMOTION_NONE ? -1 : World::emotionBits + e;
+		}
+		case MOTIVATIONS: {
+			auto m = Traits::stringToMotivation(value);
+			return m == Traits::MOTIVATION_NONE ? -1 : World::motivationBits + m;
+		}
+		case MORALITIES: {
+			auto m = Traits::stringToMorality(value);
+			return m == Traits::MORALITY_NONE ? -1 : World::moralityBits + m;
+		}
+		case INTELLIGENCE: {
+			auto i = Traits::stringToIntelligence(value);
+			return i == Traits::INTELLIGENCE_NONE ? -1 : World::intelligenceBits + i;
+		}
+		case BACKGROUND: {
+			auto b = Traits::stringToBackground(value);
+			return b == Traits::BACKGROUND_NONE ? -1 : World::backgroundBits + b;
+		}
+		default:
+			return -1;
+		}
+	}
+
+	struct Row {
+		std::string name;
+		uint8_t personality;
+		uint64_t traits;
+		uint16_t club;
+
+		Row() : name(""), personality(Traits::PERSONALITY_NONE), traits(0), club(noClub) {}
+	};
+
+	// one parsed block in column layout, appended to the world in one go
+	struct Batch {
+		std::string nameChars;
+		std::vector<uint32_t> nameEnds;
+		std::vector<uint8_t> personality;
+		std::vector<uint64_t> traits;
+		std::vector<uint16_t> club;
+		size_t skipped;
+
+		Batch() : skipped(0) {}
+
+		void add(const Row& row) {
+			if (row.name.empty()) {
+				this->skipped++;
+				return;
+			}
+			this->nameChars += row.name;
+			this->nameEnds.push_back((uint32_t)this->nameChars.size());
+			this->personality.push_back(row.personality);
+			this->traits.push_back(row.traits);
+			this->club.push_back(row.club);
+		}
+	};
+
+	struct Block {
+		std::string text;
+		std::vector<std::pair<uint32_t, uint32_t>> records; // JSON element ranges inside text
+		Batch batch;
+		std::atomic<bool> done;
+
+		Block() : done(false) {}
+	};
+
+	// SAX handler for one top-level element, only objects produce a row
+	class RecordHandler {
+	private:
+		Row& row;
+		Field field;
+		int depth;
+	public:
+		explicit RecordHandler(Row& row) : row(row), field(UNKNOWN_FIELD), depth(0) {}
+
+		bool null() { return true; }
+		bool boolean(bool) { return true; }
+		bool number_integer(json::number_integer_t value) {
+			if (this->depth == 1 && this->field == CLUB && value >= 0 && value < noClub) {
+				this->row.club = (uint16_t)value;
+			}
+			return true;
+		}
+		bool number_unsigned(json::number_unsigned_t value) {
+			if (this->depth == 1 && this->field == CLUB && value < noClub) {
+				this->row.club = (uint16_t)value;
+			}
+			return true;
+		}
+		bool number_float(json::number_float_t, const json::string_t&) { return true; }
+		bool string(json::string_t& value) {
+			if (this->depth == 1 && this->field == NAME) {
+				this->row.name = std::move(value);
+			}
+			else if (this->depth == 1 && this->field == PERSONALITY) {
+				this->row.personality = (uint8_t)Traits::stringToPersonalities(value);
+			}
+			else if (this->depth == 2) {
+				int bit = traitBit(this->field, value);
+				if (bit >= 0) {
+					this->row.traits |= 1ull << bit;
+				}
+			}
+			return true;
+		}
+		bool binary(json::binary_t&) { return true; }
+		bool start_object(size_t) {
+			this->depth++;
+			return true;
+		}
+		bool key(json::string_t& key) {
+			if (this->depth == 1) {
+				this->field = fieldOf(key);
+			}
+			return true;
+		}
+		bool end_object() {
+			this->depth--;
+			return true;
+		}
+		bool start_array(size_t) {
+			this->depth++;
+			return true;
+		}
+		bool end_array() {
+			this->depth--;
+			return true;
+		}
+		bool parse_error(size_t, const std::string&, const nlohmann::detail::exception&) { return false; }
+	};
+
+	/*
+	* Finds where the elements of the top-level array start and end without parsing them,
+	* a byte at a time with just enough state to skip strings. Offsets are shifted by
+	* dropFront when the reader cuts the buffer, so the scan never restarts.
+	*/
+	class JsonScanner {
+	private:
+		size_t pos;
+		int depth;
+		bool inString;
+		bool escape;
+		int64_t elementStart;
+	public:
+		JsonScanner() : pos(0), depth(0), inString(false), escape(false), elementStart(-1) {}
+
+		bool insideElement() const { return this->elementStart >= 0; }
+
+		void scan(const std::string& text, std::vector<std::pair<uint32_t, uint32_t>>& records) {
+			for (; this->pos < text.size(); this->pos++) {
+				const char c = text[this->pos];
+				if (this->inString) {
+					if (this->escape) {
+						this->escape = false;
+					}
+					else if (c == '\\') {
+						this->escape = true;
+					}
+					else if (c == '"') {
+						this->inString = false;
+					}
+					continue;
+				}
+				if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+					continue;
+				}
+				if (this->depth == 1 && this->elementStart < 0 && c != ',' && c != ']') {
+					this->elementStart = (int64_t)this->pos;
+				}
+				if (c == '"') {
+					this->inString = true;
+				}
+				else if (c == '{' || c == '[') {
+					this->depth++;
+				}
+				else if (c == '}' || c == ']') {
+					if (this->depth == 1 && c == ']' && this->elementStart >= 0) {
+						// a scalar as the last element
+						records.emplace_back((uint32_t)this->elementStart, (uint32_t)this->pos);
+						this->elementStart = -1;
+					}
+					this->depth--;
+					if (this->depth == 1 && this->elementStart >= 0) {
+						records.emplace_back((uint32_t)this->elementStart, (uint32_t)this->pos + 1);
+						this->elementStart = -1;
+					}
+				}
+				else if (c == ',' && this->depth == 1 && this->elementStart >= 0) {
+					records.emplace_back((uint32_t)this->elementStart, (uint32_t)this->pos);
+					this->elementStart = -1;
+				}
+			}
+		}
+
+		void dropFront(size_t bytes) {
+			this->pos -= bytes;
+			if (this->elementStart >= 0) {
+				this->elementStart -= (int64_t)bytes;
+			}
+		}
+	};
+
+	// line ends outside of quoted fields
+	class CsvScanner {
+	private:
+		size_t pos;
+		bool inQuotes;
+	public:
+		CsvScanner() : pos(0), inQuotes(false) {}
+
+		// returns the end of the last complete line, 0 if there is none yet
+		size_t scan(const std::string& text) {
+			size_t lastEnd = 0;
+			for (; this->pos < text.size(); this->pos++) {
+				const char c = text[this->pos];
+				if (c == '"') {
+					this->inQuotes = !this->inQuotes;
+				}
+				else if (c == '\n' && !this->inQuotes) {
+					lastEnd = this->pos + 1;
+				}
+			}
+			return lastEnd;
+		}
+
+		void dropFront(size_t bytes) { this->pos -= bytes; }
+	};
+
+	static void parseJsonBlock(Block& block) {
+		for (auto& record : block.records) {
+			Row row;
+			RecordHandler handler(row);
+			const char* begin = block.text.data() + record.first;
+			const char* end = block.text.data() + record.second;
+			if (!json::sax_parse(begin, end, &handler)) {
+				block.batch.skipped++;
+				continue;
+			}
+			block.batch.add(row);
+		}
+	}
+
+	static void applyCsvField(Row& row, Field field, const std::string& value) {
+		switch (field) {
+		case NAME:
+			row.name = value;
+			break;
+		case PERSONALITY:
+			row.personality = (uint8_t)Traits::stringToPersonalities(value);
+			break;
+		case CLUB: {
+			char* end = nullptr;
+			unsigned long club = std::strtoul(value.c_str(), &end, 10);
+			if (end != value.c_str() && club < noClub) {
+				row.club = (uint16_t)club;
+			}
+			break;
+		}
+		case UNKNOWN_FIELD:
+			break;
+		default: {
+			size_t begin = 0;
+			while (begin <= value.size()) {
+				size_t end = value.find(';', begin);
+				if (end == std::string::npos) {
+					end = value.size();
+				}
+				int bit = traitBit(field, value.substr(begin, end - begin));
+				if (bit >= 0) {
+					row.traits |= 1ull << bit;
+				}
+				begin = end + 1;
+			}
+			break;
+		}
+		}
+	}
+
+	static void parseCsvBlock(Block& block, const std::vector<Field>& columns) {
+		const std::string& text = block.text;
+		const size_t n = text.size();
+		std::string value;
+		size_t i = 0;
+
+		while (i < n) {
+			if (text[i] == '\r' || text[i] == '\n') {
+				i++;
+				continue;
+			}
+
+			Row row;
+			size_t column = 0;
+			while (true) {
+				value.clear();
+				if (i < n && text[i] == '"') {
+					// quoted field, "" is a literal quote
+					i++;
+					while (i < n) {
+						if (text[i] == '"') {
+							if (i + 1 < n && text[i + 1] == '"') {
+								value += '"';
+								i += 2;
+								continue;
+							}
+							i++;
+							break;
+						}
+						value += text[i++];
+					}
+				}
+				while (i < n && text[i] != ',' && text[i] != '\n' && text[i] != '\r') {
+					value += text[i++];
+				}
+				if (column < columns.size()) {
+					applyCsvField(row, columns[column], value);
+				}
+				if (i < n && text[i] == ',') {
+					i++;
+					column++;
+					continue;
+				}
+				break;
+			}
+			block.batch.add(row);
+		}
+	}
+
+	static void append(World::WorldState& world, const Batch& batch, Stats& stats) {
+		World::CharacterColumns& c = world.characters;
+		if (c.names.offsets.empty()) {
+			c.names.offsets.push_back(0);
+		}
+		const uint32_t base = (uint32_t)c.names.chars.size();
+		c.names.chars.append(batch.nameChars.data(), batch.nameChars.size());
+		for (uint32_t end : batch.nameEnds) {
+			c.names.offsets.push_back(base + end);
+		}
+		c.personality.append(batch.personality.data(), batch.personality.size());
+		c.traits.append(batch.traits.data(), batch.traits.size());
+		c.club.append(batch.club.data(), batch.club.size());
+
+		stats.rows += batch.nameEnds.size();
+		stats.skipped += batch.skipped;
+	}
+
+	static std::vector<Field> parseCsvHeader(const std::string& line) {
+		std::vector<Field> columns;
+		size_t begin = 0;
+		while (begin <= line.size()) {
+			size_t end = line.find(',', begin);
+			if (end == std::string::npos) {
+				end = line.size();
+			}
+			std::string name = line.substr(begin, end - begin);
+			name.erase(std::remove_if(name.begin(), name.end(), [](char c) { return c == '"' || c == ' ' || c == '\r'; }), name.end());
+			columns.push_back(fieldOf(name));
+			begin = end + 1;
+		}
+		return columns;
+	}
+}
+
+Import::Stats Import::importFile(const std::string& path, World::WorldState& world) {
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return importFile(path, extension == ".csv" ? CSV : JSON, world);
+}
+
+Import::Stats Import::importFile(const std::string& path, Format format, World::WorldState& world) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Could not open " + path);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Stats stats;
+	Jobs::ThreadPool* pool = Jobs::ThreadPool::getPool();
+	std::deque<std::shared_ptr<Block>> inFlight;
+
+	auto commitOldest = [&]() {
+		std::shared_ptr<Block> block = inFlight.front();
+		inFlight.pop_front();
+		while (!block->done.load(std::memory_order_acquire)) {
+			block->done.wait(false);
+		}
+		append(world, block->batch, stats);
+	};
+
+	std::shared_ptr<const std::vector<Field>> columns;
+	auto submit = [&](std::shared_ptr<Block> block) {
+		while (inFlight.size() >= maxBlocksInFlight(pool->size())) {
+			commitOldest();
+		}
+		inFlight.push_back(block);
+		auto parse = [block, format, columns]() {
+			if (format == JSON) {
+				parseJsonBlock(*block);
+			}
+			else {
+				parseCsvBlock(*block, *columns);
+			}
+			block->text = std::string();
+			block->done.store(true, std::memory_order_release);
+			block->done.notify_all();
+		};
+		// commitOldest waits on the block, which a worker importing on its own pool could be the one to run
+		if (pool->isWorkerThread()) {
+			parse();
+		}
+		else {
+			pool->submit(parse);
+		}
+	};
+
+	if (format == CSV) {
+		std::string header;
+		std::getline(file, header);
+		stats.bytes += header.size() + 1;
+		columns = std::make_shared<const std::vector<Field>>(parseCsvHeader(header));
+		if (std::find(columns->begin(), columns->end(), NAME) == columns->end()) {
+			throw std::runtime_error(path + " has no name column.");
+		}
+	}
+
+	JsonScanner jsonScanner;
+	CsvScanner csvScanner;
+	std::string buffer;
+	std::vector<char> chunk(blockBytes);
+	while (file) {
+		file.read(chunk.data(), chunk.size());
+		const size_t got = (size_t)file.gcount();
+		if (got == 0) {
+			break;
+		}
+		stats.bytes += got;
+		buffer.append(chunk.data(), got);
+
+		auto block = std::make_shared<Block>();
+		size_t cut = 0;
+		if (format == JSON) {
+			jsonScanner.scan(buffer, block->records);
+			cut = block->records.empty() ? 0 : block->records.back().second;
+		}
+		else {
+			cut = csvScanner.scan(buffer);
+		}
+		if (cut == 0) {
+			// one record longer than a block, keep reading until it ends
+			continue;
+		}
+
+		block->text = buffer.substr(0, cut);
+		buffer.erase(0, cut);
+		jsonScanner.dropFront(format == JSON ? cut : 0);
+		csvScanner.dropFront(format == CSV ? cut : 0);
+		submit(block);
+	}
+
+	// a CSV without a trailing newline still has its last line
+	if (format == CSV && buffer.find_first_not_of(" \t\r\n") != std::string::npos) {
+		auto block = std::make_shared<Block>();
+		block->text = std::move(buffer);
+		submit(block);
+	}
+	else if (format == JSON && jsonScanner.insideElement()) {
+		ERROR(path << " ends in the middle of a record, it was skipped.");
+		stats.skipped++;
+	}
+
+	while (!inFlight.empty()) {
+		commitOldest();
+	}
+
+	stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	stats.peakResidentBytes = peakResidentBytes();
+	return stats;
+}
+
+uint64_t Import::peakResidentBytes() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return (uint64_t)counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	return (uint64_t)usage.ru_maxrss;
+#else
+	return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+void Import::Stats::print() const {
+	LOG("Imported " << this->rows << " players (" << this->skipped << " skipped) from " << this->bytes / (1024 * 1024) << " MB in "
+		<< this->ms << " ms, " << (uint64_t)(this->rows / (this->ms / 1000.0)) << " rows/s, peak RSS "
+		<< this->peakResidentBytes / (1024 * 1024) << " MB");
+}
+
+void Import::benchmark(size_t players) {
+	static const char* personalities[] = { "LEADER", "CAREGIVER", "THINKER", "ADVENTURER", "ORGANIZER", "PEACEMAKER", "DREAMER", "PERFORMER", "LOYALIST" };
+	static const char* emotions[] = { "ANGRY", "FINE", "RELAXED", "SAD", "CONFUSED", "INSPIRED" };
+	static const char* motivations[] = { "POWER", "WEALTH", "LOVE", "KNOWLEDGE", "FREEDOM", "RESTRICTED", "SAFETY", "FAIRNESS" };
+	static const char* backgrounds[] = { "WEALTHY", "EDUCATED", "RURAL", "INDEPENDENT", "RELIGIOUS", "POOR", "UNEDUCATED", "URBAN" };
+
+	const std::string jsonPath = "benchmark_players.json";
+	const std::string csvPath = "benchmark_players.csv";
+	{
+		std::mt19937 rng(7);
+		std::ofstream jsonFile(jsonPath, std::ios::binary);
+		std::ofstream csvFile(csvPath, std::ios::binary);
+		csvFile << "name,personality,club,emotions,motivations,background\n";
+		jsonFile << "[\n";
+		for (size_t i = 0; i < players; i++) {
+			const char* personality = personalities[rng() % 9];
+			const uint16_t club = (uint16_t)(rng() % 2000);
+			const char* e1 = emotions[rng() % 6];
+			const char* e2 = emotions[rng() % 6];
+			const char* motivation = motivations[rng() % 8];
+			const char* background = backgrounds[rng() % 8];
+
+			csvFile << "\"Player \"\"" << i << "\"\"\"," << personality << ',' << club << ',' << e1 << ';' << e2 << ','
+				<< motivation << ',' << background << '\n';
+			jsonFile << "  {\"name\": \"Player \\\"" << i << "\\\"\", \"personality\": \"" << personality << "\", \"club\": " << club
+				<< ", \"emotions\": [\"" << e1 << "\", \"" << e2 << "\"], \"motivations\": [\"" << motivation
+				<< "\"], \"background\": [\"" << background << "\"]}" << (i + 1 < players ? ",\n" : "\n");
+		}
+		jsonFile << "]\n";
+	}
+
+	World::WorldState fromJson;
+	Stats jsonStats = importFile(jsonPath, fromJson);
+	jsonStats.print();
+	World::WorldState fromCsv;
+	Stats csvStats = importFile(csvPath, fromCsv);
+	csvStats.print();
+
+	bool matches = fromJson.characters.names.size() == players && fromCsv.characters.names.size() == players
+		&& fromJson.characters.names.get(players - 1) == fromCsv.characters.names.get(players - 1)
+		&& fromJson.characters.traits[players / 2] == fromCsv.characters.traits[players / 2]
+		&& fromJson.characters.club[players / 3] == fromCsv.characters.club[players / 3];
+	if (!matches) {
+		ERROR("JSON and CSV imports of the same players don't match.");
+	}
+	std::filesystem::remove(jsonPath);
+	std::filesystem::remove(csvPath);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "world.h"
+
+namespace Import {
+	/*
+	* Streams community player databases into the character columns without ever holding the
+	* whole file or a DOM of it. The reader thread cuts the input into blocks at record
+	* boundaries, the job pool parses blocks into column batches, and the batches are appended
+	* to the world in file order. At most maxBlocksInFlight blocks exist at once, which bounds
+	* memory no matter how large the file is.
+	*
+	* JSON: a top-level array of objects, CSV: a header row and one player per line. Both use
+	* the fields name, personality, club, emotions, motivations, moralities, intelligence and
+	* background. Trait fields are arrays in JSON and ';' separated lists in CSV, values are
+	* the trait enum names (LEADER, ANGRY, ...).
+	*/
+	constexpr size_t blockBytes = 1 << 20;
+	// enough to keep every worker busy while the reader commits the oldest block
+	inline size_t maxBlocksInFlight(size_t workers) { return workers + 2; }
+
+	enum Format : uint8_t {
+		JSON,
+		CSV
+	};
+
+	struct Stats {
+		size_t rows;
+		size_t skipped; // rows without a name or that didn't parse
+		uint64_t bytes;
+		double ms;
+		uint64_t peakResidentBytes;
+
+		Stats() : rows(0), skipped(0), bytes(0), ms(0.0), peakResidentBytes(0) {}
+		void print() const;
+	};
+
+	// picks the format from the extension, throws when the file can't be read
+	Stats importFile(const std::string& path, World::WorldState& world);
+	Stats importFile(const std::string& path, Format format, World::WorldState& world);
+
+	uint64_t peakResidentBytes();
+
+	void benchmark(size_t players = 500000);
+}
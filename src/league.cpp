@@ -0,0 +1,100 @@
+#include "league.h"
+#include <numeric>
+#include <algorithm>
+#include <chrono>
+#include "handball_rules.h"
+#include "logging.h"
+
+League::LeagueState::LeagueState(const std::string& name, Modes::SportModes sport, std::vector<Match::TeamSheet> clubs, std::vector<Fixture> fixtures, uint8_t relegationSpots) :
+	clubs(std::make_shared<const std::vector<Match::TeamSheet>>(std::move(clubs))),
+	fixtures(std::make_shared<const std::vector<Fixture>>(std::move(fixtures))),
+	name(name), sport(sport), relegationSpots(relegationSpots), playedFixtures(0) {
+	this->table = std::vector<Standing>(this->clubs->size());
+}
+
+std::vector<Match::TeamSheet>& League::LeagueState::editClubs() {
+	if (this->clubs.use_count() > 1) {
+		this->clubs = std::make_shared<const std::vector<Match::TeamSheet>>(*this->clubs);
+	}
+	return const_cast<std::vector<Match::TeamSheet>&>(*this->clubs);
+}
+
+std::vector<League::Fixture>& League::LeagueState::editFixtures() {
+	if (this->fixtures.use_count() > 1) {
+		this->fixtures = std::make_shared<const std::vector<Fixture>>(*this->fixtures);
+	}
+	return const_cast<std::vector<Fixture>&>(*this->fixtures);
+}
+
+void League::LeagueState::recordResult(const Fixture& fixture, uint16_t homeScore, uint16_t awayScore, uint16_t pointsForWin, uint16_t pointsForDraw) {
+	Standing& home = this->table[fixture.home];
+	Standing& away = this->table[fixture.away];
+
+	home.played++;
+	away.played++;
+	home.scored += homeScore;
+	away.scored += awayScore;
+	home.scoreDiff += (int16_t)homeScore - (int16_t)awayScore;
+	away.scoreDiff += (int16_t)awayScore - (int16_t)homeScore;
+
+	if (homeScore > awayScore) {
+		home.points += pointsForWin;
+	}
+	else if (homeScore < awayScore) {
+		away.points += pointsForWin;
+	}
+	else {
+		home.points += pointsForDraw;
+		away.points += pointsForDraw;
+	}
+}
+
+void League::LeagueState::rankInto(std::vector<uint16_t>& order) const {
+	order.resize(this->table.size());
+	std::iota(order.begin(), order.end(), (uint16_t)0);
+	std::sort(order.begin(), order.end(), [this](uint16_t a, uint16_t b) {
+		const Standing& l = this->table[a];
+		const Standing& r = this->table[b];
+		if (l.points != r.points) return l.points > r.points;
+		if (l.scoreDiff != r.scoreDiff) return l.scoreDiff > r.scoreDiff;
+		if (l.scored != r.scored) return l.scored > r.scored;
+		return a < b;
+	});
+}
+
+void League::playRound(LeagueState& state, std::mt19937& rng, bool watched, uint16_t userClub) {
+	switch (state.sport) {
+	case Modes::HANDBALL:
+		playRound<Match::RulesFor<Modes::HANDBALL>::type>(state, rng, watched, userClub);
+		break;
+	default:
+		ERROR("No match engine for " << state.name << "'s sport.");
+		break;
+	}
+}
+
+void League::prepare(Modes::SportModes sport) {
+	auto start = std::chrono::steady_clock::now();
+
+	switch (sport) {
+	case Modes::HANDBALL:
+		Match::Calibration<Match::RulesFor<Modes::HANDBALL>::type>::get();
+		break;
+	default:
+		return;
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	DEBUG("Prepared the match calibration in " << elapsed.count() / 1000.0 << " ms");
+}
+
+void League::simulateWeek(std::vector<LeagueState>& leagues, size_t userLeague, uint16_t userClub, std::mt19937& rng) {
+	auto start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < leagues.size(); i++) {
+		playRound(leagues[i], rng, i == userLeague, userClub);
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	DEBUG("Simulated a week across " << leagues.size() << " leagues in " << elapsed.count() / 1000.0 << " ms");
+}
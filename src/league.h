@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include "match_lod.h"
+
+namespace League {
+	struct Fixture {
+		uint16_t home;
+		uint16_t away;
+		uint16_t round;
+
+		Fixture() : home(0), away(0), round(0) {}
+		Fixture(uint16_t h, uint16_t a, uint16_t r) : home(h), away(a), round(r) {}
+	};
+
+	struct Standing {
+		uint16_t played;
+		uint16_t points;
+		int16_t scoreDiff;
+		uint16_t scored;
+
+		Standing() : played(0), points(0), scoreDiff(0), scored(0) {}
+	};
+
+	/*
+	* Clubs and fixtures are shared between copies and only cloned when one of them is
+	* modified, so forking a league for a what-if simulation only copies the table.
+	*/
+	class LeagueState {
+	private:
+		std::shared_ptr<const std::vector<Match::TeamSheet>> clubs;
+		std::shared_ptr<const std::vector<Fixture>> fixtures;
+
+	public:
+		std::string name;
+		Modes::SportModes sport;
+		uint8_t relegationSpots;
+		size_t playedFixtures;
+		std::vector<Standing> table;
+
+		LeagueState() : sport(Modes::NONE_SPORT), relegationSpots(0), playedFixtures(0) {}
+		LeagueState(const std::string& name, Modes::SportModes sport, std::vector<Match::TeamSheet> clubs, std::vector<Fixture> fixtures, uint8_t relegationSpots);
+
+		const std::vector<Match::TeamSheet>& getClubs() const { return *this->clubs; }
+		const std::vector<Fixture>& getFixtures() const { return *this->fixtures; }
+		std::vector<Match::TeamSheet>& editClubs();
+		std::vector<Fixture>& editFixtures();
+
+		size_t clubCount() const { return this->clubs ? this->clubs->size() : 0; }
+		LeagueState fork() const { return *this; }
+
+		void recordResult(const Fixture& fixture, uint16_t homeScore, uint16_t awayScore, uint16_t pointsForWin, uint16_t pointsForDraw);
+		void rankInto(std::vector<uint16_t>& order) const;
+	};
+
+	// plays the next fixture, returns false once the season is over
+	template <typename Rules>
+	bool playNextFixture(LeagueState& state, std::mt19937& rng, Match::Tier tier = Match::STATISTICAL) {
+		if (state.playedFixtures >= state.getFixtures().size()) {
+			return false;
+		}
+		const Fixture& f = state.getFixtures()[state.playedFixtures];
+		auto res = Match::simulate<Rules>(tier, state.getClubs()[f.home], state.getClubs()[f.away], rng);
+		state.recordResult(f, res.homeScore, res.awayScore, Rules::pointsForWin, Rules::pointsForDraw);
+		state.playedFixtures++;
+		return true;
+	}
+
+	/*
+	* Plays every fixture of the next round. Matches of the watched club get the full engine,
+	* the rest of a watched league the statistical model and background leagues the result-only one.
+	*/
+	template <typename Rules>
+	void playRound(LeagueState& state, std::mt19937& rng, bool watched, uint16_t userClub) {
+		if (state.playedFixtures >= state.getFixtures().size()) {
+			return;
+		}
+		const uint16_t round = state.getFixtures()[state.playedFixtures].round;
+
+		while (state.playedFixtures < state.getFixtures().size() && state.getFixtures()[state.playedFixtures].round == round) {
+			const Fixture& f = state.getFixtures()[state.playedFixtures];
+			Match::Tier tier = Match::RESULT_ONLY;
+			if (watched) {
+				tier = (f.home == userClub || f.away == userClub) ? Match::FULL : Match::STATISTICAL;
+			}
+			playNextFixture<Rules>(state, rng, tier);
+		}
+	}
+
+	void playRound(LeagueState& state, std::mt19937& rng, bool watched, uint16_t userClub);
+
+	// builds the sport's match calibration, about half a second of full matches, so run it off the main thread
+	void prepare(Modes::SportModes sport);
+
+	// one round in every league, only userLeague is simulated in detail
+	void simulateWeek(std::vector<LeagueState>& leagues, size_t userLeague, uint16_t userClub, std::mt19937& rng);
+}
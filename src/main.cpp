@@ -1,6 +1,25 @@
 #include "game.h"
+#include <cstring>
+
+int main(int argc, char** argv) {
+	// headless runs for bug reports and benchmarks, neither opens a window
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			Replay::Journal journal;
+			if (!Replay::Journal::read(argv[i + 1], journal)) {
+				return 1;
+			}
+			Replay::Result res = Replay::runHeadless(journal);
+			LOG("Replayed " << argv[i + 1] << " to day " << res.days << " (" << res.seasons << " seasons) in " << res.ms << " ms, digest "
+				<< res.digest << (res.firstDivergence == SIZE_MAX ? "" : ", it diverged from the recording"));
+			return res.firstDivergence == SIZE_MAX ? 0 : 1;
+		}
+		if (std::strcmp(argv[i], "--bench-replay") == 0) {
+			Replay::benchmark();
+			return 0;
+		}
+	}
 
-int main() {
 	Game::Game game = Game::Game();
 	game.run();
 	
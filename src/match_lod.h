@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include "sport_kernel.h"
+
+namespace Match {
+	enum Tier : uint8_t {
+		FULL,		// play-by-play kernel, for matches the user watches
+		STATISTICAL,	// calibrated score and shot model, for the rest of the user's league
+		RESULT_ONLY	// one random draw per match, for leagues nobody is looking at
+	};
+
+	/*
+	* Score distributions measured from the full kernel on a grid of rating edges, one cell per
+	* pair of home and away edge. A cell keeps a stratified sample of whole results: the full
+	* engine's scorelines sorted by goal difference and then total, with one picked from the
+	* middle of each quantile. The cheaper tiers draw a scoreline from it, so home and away
+	* scores stay correlated and draw rates and points follow the full engine for any sport
+	* without per-sport tuning.
+	*
+	* Edges are taken after fatigue: each rating is scaled by the mean fitness its side's stamina
+	* keeps up over a match under the sport's substitution rules, and the grid is played by
+	* average-stamina sides whose raw ratings give the same scaled edges.
+	*/
+	template <typename Rules>
+	class Calibration {
+	public:
+		static constexpr uint8_t edgeBuckets = 11;
+		static constexpr float minEdge = -0.5f;
+		static constexpr float maxEdge = 0.5f;
+		static constexpr uint8_t quantiles = 64;
+		static constexpr uint16_t samplesPerBucket = 512;
+		static constexpr uint8_t staminaSteps = 11;
+
+		struct Bucket {
+			std::array<uint16_t, quantiles> homeScore;
+			std::array<uint16_t, quantiles> awayScore;
+			float homeShots;
+			float awayShots;
+		};
+
+		// [home edge][away edge]
+		std::array<std::array<Bucket, edgeBuckets>, edgeBuckets> buckets;
+		// mean match fitness for stamina 0, 0.1, ... 1
+		std::array<float, staminaSteps> fitness;
+
+		// League::prepare builds it on the pool at startup, a match that gets here first waits for
+		// that build through the static initialization instead of starting its own
+		static const Calibration& get() {
+			static const Calibration instance = Calibration();
+			return instance;
+		}
+
+		float fitnessOf(float stamina) const {
+			float pos = std::clamp(stamina, 0.f, 1.f) * (staminaSteps - 1);
+			uint8_t low = std::min<uint8_t>((uint8_t)pos, staminaSteps - 2);
+			return this->fitness[low] + (this->fitness[low + 1] - this->fitness[low]) * (pos - low);
+		}
+
+		float edgeOf(const TeamSheet& attacking, const TeamSheet& defending) const {
+			float edge = attacking.attack * this->fitnessOf(attacking.stamina) - defending.defence * this->fitnessOf(defending.stamina);
+			return std::clamp(edge, minEdge, maxEdge);
+		}
+
+		static float bucketOf(float edge) {
+			return (edge - minEdge) / (maxEdge - minEdge) * (edgeBuckets - 1);
+		}
+
+	private:
+		Calibration();
+	};
+
+	template <typename Rules>
+	Calibration<Rules>::Calibration() {
+		std::mt19937 rng(0xCA11B8);
+		std::vector<std::pair<uint16_t, uint16_t>> scores(samplesPerBucket);
+
+		for (uint8_t i = 0; i < staminaSteps; i++) {
+			this->fitness[i] = ContinuousKernel<Rules>::meanFitness((float)i / (staminaSteps - 1));
+		}
+		// raw ratings of the grid's sides are divided by this to land on the scaled edges
+		const float gridFitness = this->fitnessOf(0.5f);
+
+		for (uint8_t h = 0; h < edgeBuckets; h++) {
+			for (uint8_t a = 0; a < edgeBuckets; a++) {
+				float homeEdge = minEdge + (maxEdge - minEdge) * h / (edgeBuckets - 1);
+				float awayEdge = minEdge + (maxEdge - minEdge) * a / (edgeBuckets - 1);
+				float homeRaw = homeEdge / gridFitness;
+				float awayRaw = awayEdge / gridFitness;
+				TeamSheet home(0.5f + homeRaw / 2.f, 0.5f - awayRaw / 2.f, 0.5f);
+				TeamSheet away(0.5f + awayRaw / 2.f, 0.5f - homeRaw / 2.f, 0.5f);
+
+				uint32_t homeShots = 0;
+				uint32_t awayShots = 0;
+				for (uint16_t i = 0; i < samplesPerBucket; i++) {
+					auto res = ContinuousKernel<Rules>::simulate(home, away, rng);
+					scores[i] = { res.homeScore, res.awayScore };
+					homeShots += res.homeShots;
+					awayShots += res.awayShots;
+				}
+				std::sort(scores.begin(), scores.end(), [](const auto& x, const auto& y) {
+					const int dx = (int)x.first - x.second;
+					const int dy = (int)y.first - y.second;
+					return dx != dy ? dx < dy : x.first + x.second < y.first + y.second;
+				});
+
+				Bucket& bucket = this->buckets[h][a];
+				for (uint8_t q = 0; q < quantiles; q++) {
+					size_t index = ((size_t)q * 2 + 1) * samplesPerBucket / (quantiles * 2);
+					bucket.homeScore[q] = scores[index].first;
+					bucket.awayScore[q] = scores[index].second;
+				}
+				bucket.homeShots = (float)homeShots / samplesPerBucket;
+				bucket.awayShots = (float)awayShots / samplesPerBucket;
+			}
+		}
+	}
+
+	template <typename Rules>
+	Result simulateStatistical(const TeamSheet& home, const TeamSheet& away, std::mt19937& rng) {
+		using Cal = Calibration<Rules>;
+		const Cal& cal = Cal::get();
+		std::uniform_real_distribution<float> chance(0.f, 1.f);
+
+		// interpolate between the two neighbouring buckets by picking one at random
+		auto pick = [&](float edge) -> uint8_t {
+			float pos = Cal::bucketOf(edge);
+			uint8_t low = (uint8_t)pos;
+			return (low + 1 < Cal::edgeBuckets && chance(rng) < pos - low) ? low + 1 : low;
+		};
+
+		const uint8_t h = pick(cal.edgeOf(home, away));
+		const uint8_t a = pick(cal.edgeOf(away, home));
+		const auto& bucket = cal.buckets[h][a];
+		// the distribution can return its upper bound
+		const uint8_t q = std::min<uint8_t>((uint8_t)(chance(rng) * Cal::quantiles), Cal::quantiles - 1);
+
+		Result res;
+		res.homeScore = bucket.homeScore[q];
+		res.awayScore = bucket.awayScore[q];
+		res.homeShots = (uint16_t)std::lround(bucket.homeShots);
+		res.awayShots = (uint16_t)std::lround(bucket.awayShots);
+		return res;
+	}
+
+	template <typename Rules>
+	Result simulateResultOnly(const TeamSheet& home, const TeamSheet& away, std::mt19937& rng) {
+		using Cal = Calibration<Rules>;
+		static_assert(Cal::quantiles <= 256, "Quantile index is drawn from 8 bits.");
+		const Cal& cal = Cal::get();
+
+		// one draw picks the whole scoreline, its upper bytes interpolate between neighbouring buckets
+		// so edges smaller than a bucket, like a stamina gap, still shift the odds
+		const uint32_t draw = rng();
+		auto pick = [](float edge, uint32_t bits) -> uint8_t {
+			float pos = Cal::bucketOf(edge);
+			uint8_t low = (uint8_t)pos;
+			return (low + 1 < Cal::edgeBuckets && bits < (uint32_t)((pos - low) * 256.f)) ? low + 1 : low;
+		};
+		const auto& bucket = cal.buckets[pick(cal.edgeOf(home, away), (draw >> 8) & 0xFF)][pick(cal.edgeOf(away, home), (draw >> 16) & 0xFF)];
+		const uint32_t q = (draw & 0xFF) * Cal::quantiles >> 8;
+		Result res;
+		res.homeScore = bucket.homeScore[q];
+		res.awayScore = bucket.awayScore[q];
+		return res;
+	}
+
+	template <typename Rules>
+	Result simulate(Tier tier, const TeamSheet& home, const TeamSheet& away, std::mt19937& rng) {
+		switch (tier) {
+		case FULL:
+			return ContinuousKernel<Rules>::template simulate<true>(home, away, rng);
+		case STATISTICAL:
+			return simulateStatistical<Rules>(home, away, rng);
+		default:
+			return simulateResultOnly<Rules>(home, away, rng);
+		}
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace Modes {
+	enum GameMode {
+		E_SPORT,
+		SPORT
+	};
+
+	enum EsportModes {
+		MOBA,
+		SHOOTER,
+		NONE_ESPORT
+	};
+
+	enum SportModes {
+		FOOTBALL,
+		BASKETBALL,
+		HANDBALL,
+		NONE_SPORT
+	};
+}
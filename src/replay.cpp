@@ -0,0 +1,199 @@
+#include "replay.h"
+#include "logging.h"
+#include <fstream>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+namespace Replay {
+	static Journal* recorder = nullptr;
+
+	template <typename T>
+	static bool put(FILE* file, const T& value) {
+		return std::fwrite(&value, sizeof(T), 1, file) == 1;
+	}
+
+	static bool putString(FILE* file, const std::string& value) {
+		uint16_t length = (uint16_t)std::min<size_t>(value.size(), UINT16_MAX);
+		return put(file, length) && std::fwrite(value.data(), 1, length, file) == length;
+	}
+
+	template <typename T>
+	static bool get(std::ifstream& file, T& value) {
+		return (bool)file.read((char*)&value, sizeof(T));
+	}
+
+	static bool getString(std::ifstream& file, std::string& value) {
+		uint16_t length;
+		if (!get(file, length)) {
+			return false;
+		}
+		value.resize(length);
+		return length == 0 || (bool)file.read(value.data(), length);
+	}
+}
+
+void Replay::Journal::begin(const std::string& path, const Career::Setup& setup) {
+	this->close();
+	this->setup = setup;
+	this->entries.clear();
+	this->today = 0;
+
+	this->file = std::fopen(path.c_str(), "wb");
+	if (!this->file) {
+		ERROR("Could not open " << path << ", this career won't be journaled.");
+		return;
+	}
+	bool ok = std::fwrite(journalMagic, 1, sizeof(journalMagic), this->file) == sizeof(journalMagic);
+	ok = ok && put(this->file, journalVersion);
+	ok = ok && put(this->file, setup.seed) && put(this->file, (uint8_t)setup.sport);
+	ok = ok && put(this->file, setup.leagues) && put(this->file, setup.clubsPerLeague);
+	ok = ok && put(this->file, setup.userLeague) && put(this->file, setup.userClub);
+	if (!ok || std::fflush(this->file) != 0) {
+		ERROR("Failed to write " << path << ", this career won't be journaled.");
+		this->close();
+	}
+}
+
+void Replay::Journal::record(const Entry& entry) {
+	this->entries.push_back(entry);
+	if (entry.kind == ADVANCE_DAYS) {
+		this->today = entry.day;
+	}
+	if (!this->file) {
+		return;
+	}
+	bool ok = put(this->file, (uint8_t)entry.kind) && put(this->file, entry.day);
+	ok = ok && put(this->file, entry.value) && put(this->file, entry.check);
+	ok = ok && putString(this->file, entry.target) && putString(this->file, entry.text);
+	if (!ok || std::fflush(this->file) != 0) {
+		ERROR("Failed to append to the replay journal, recording stopped.");
+		this->close();
+	}
+}
+
+void Replay::Journal::close() {
+	if (this->file) {
+		std::fclose(this->file);
+		this->file = nullptr;
+	}
+}
+
+bool Replay::Journal::read(const std::string& path, Journal& journal) {
+	std::ifstream file(path, std::ios::binary);
+	char magic[sizeof(journalMagic)];
+	uint32_t version;
+	if (!file || !file.read(magic, sizeof(magic)) || std::memcmp(magic, journalMagic, sizeof(magic)) != 0) {
+		ERROR(path << " is not a replay journal.");
+		return false;
+	}
+	if (!get(file, version) || version == 0 || version > journalVersion) {
+		ERROR(path << " has unsupported journal version " << version);
+		return false;
+	}
+
+	uint8_t sport;
+	Career::Setup setup;
+	if (!get(file, setup.seed) || !get(file, sport) || !get(file, setup.leagues) || !get(file, setup.clubsPerLeague)
+		|| !get(file, setup.userLeague) || !get(file, setup.userClub)) {
+		ERROR(path << " has a truncated header.");
+		return false;
+	}
+	setup.sport = (Modes::SportModes)sport;
+	journal.close();
+	journal.setup = setup;
+	journal.entries.clear();
+	journal.today = 0;
+
+	// a crash can leave half an entry at the end, everything before it is still good
+	while (true) {
+		Entry entry;
+		uint8_t kind;
+		if (!get(file, kind) || !get(file, entry.day) || !get(file, entry.value) || !get(file, entry.check)
+			|| !getString(file, entry.target) || !getString(file, entry.text)) {
+			break;
+		}
+		entry.kind = (EntryKind)kind;
+		if (entry.kind == ADVANCE_DAYS) {
+			journal.today = entry.day;
+		}
+		journal.entries.push_back(std::move(entry));
+	}
+	return true;
+}
+
+Replay::Journal* Replay::getRecorder() {
+	return recorder;
+}
+
+void Replay::setRecorder(Journal* journal) {
+	recorder = journal;
+}
+
+void Replay::recordButton(const std::string& name) {
+	if (recorder) {
+		recorder->record(Entry(BUTTON_PRESS, recorder->getToday(), 0, 0, name, ""));
+	}
+}
+
+void Replay::recordText(const std::string& name, const std::string& text) {
+	if (recorder) {
+		recorder->record(Entry(TEXT_INPUT, recorder->getToday(), 0, 0, name, text));
+	}
+}
+
+Replay::Result Replay::runHeadless(const Journal& journal) {
+	auto start = std::chrono::steady_clock::now();
+
+	Calendar::TimingWheel calendar;
+	Career::Career career(journal.setup, calendar);
+	auto onEvent = [&career](const Calendar::Event& event) { career.onEvent(event); };
+
+	Result res;
+	for (size_t i = 0; i < journal.entries.size(); i++) {
+		const Entry& entry = journal.entries[i];
+		if (entry.kind != ADVANCE_DAYS) {
+			continue;
+		}
+		calendar.advanceDays((uint32_t)entry.value, onEvent);
+		if (entry.check != career.digest() && res.firstDivergence == SIZE_MAX) {
+			res.firstDivergence = i;
+			ERROR("Replay diverged at entry " << i << " (day " << calendar.getToday() << ")");
+		}
+	}
+
+	res.days = calendar.getToday();
+	res.seasons = career.getSeason();
+	res.digest = career.digest();
+	res.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return res;
+}
+
+void Replay::benchmark(uint32_t seasons) {
+	// records a career the way the game would, then replays it from the journal file alone
+	const std::string path = "benchmark.journal";
+	const Career::Setup setup(0xB0B, Modes::HANDBALL, 20, 16, 0, 0);
+
+	Journal recorded;
+	recorded.begin(path, setup);
+	Calendar::TimingWheel calendar;
+	Career::Career career(setup, calendar);
+	auto onEvent = [&career](const Calendar::Event& event) { career.onEvent(event); };
+
+	recorded.record(Entry(BUTTON_PRESS, 0, 0, 0, "Continue", ""));
+	while (career.getSeason() < seasons) {
+		calendar.advanceDays(7, onEvent);
+		recorded.record(Entry(ADVANCE_DAYS, calendar.getToday(), 7, career.digest(), "", ""));
+	}
+	recorded.close();
+
+	Journal loaded;
+	if (!Journal::read(path, loaded)) {
+		return;
+	}
+	Result res = runHeadless(loaded);
+	LOG("Replayed " << loaded.entries.size() << " journal entries (" << res.seasons << " seasons, " << setup.leagues << " leagues) in "
+		<< res.ms << " ms, " << res.seasons / (res.ms / 60000.0) << " seasons per minute"
+		<< (res.digest == career.digest() && res.firstDivergence == SIZE_MAX ? "" : ", the replay diverged"));
+	std::remove(path.c_str());
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <cstddef>
+#include <vector>
+#include "career.h"
+
+namespace Replay {
+	constexpr char journalMagic[8] = { 'M', 'G', 'R', 'J', 'R', 'N', 'L', '\0' };
+	constexpr uint32_t journalVersion = 1;
+
+	enum EntryKind : uint8_t {
+		BUTTON_PRESS, // target is the object's name
+		TEXT_INPUT, // target is the input box, text what it held when it lost focus
+		ADVANCE_DAYS // value is the number of days, check the career digest afterwards
+	};
+
+	struct Entry {
+		EntryKind kind;
+		uint32_t day;
+		uint64_t value;
+		uint64_t check;
+		std::string target;
+		std::string text;
+
+		Entry() : kind(BUTTON_PRESS), day(0), value(0), check(0), target(""), text("") {}
+		Entry(EntryKind k, uint32_t d, uint64_t v, uint64_t c, const std::string& t, const std::string& x) :
+			kind(k), day(d), value(v), check(c), target(t), text(x) {}
+	};
+
+	/*
+	* Everything needed to rebuild a career: the setup it started from (the seed included) and
+	* every decision the user made since, in order. While recording, each entry is appended and
+	* flushed right away so a crash still leaves a usable journal for the bug report.
+	* UI entries are kept for context, the simulation is driven by the ADVANCE_DAYS entries.
+	* Only the league simulation is replayed and checked: characters draw their names from the
+	* process-wide Names pool, which depends on everything generated before, so they aren't.
+	*/
+	class Journal {
+	private:
+		FILE* file;
+		uint32_t today; // day of the last ADVANCE_DAYS entry, UI entries are stamped with it
+
+		Journal(const Journal&) = delete;
+		Journal& operator=(const Journal&) = delete;
+	public:
+		Career::Setup setup;
+		std::vector<Entry> entries;
+
+		Journal() : file(nullptr), today(0), setup(), entries({}) {}
+		~Journal() { this->close(); }
+
+		void begin(const std::string& path, const Career::Setup& setup);
+		void record(const Entry& entry);
+		void close();
+		bool isRecording() const { return this->file != nullptr; }
+		uint32_t getToday() const { return this->today; }
+
+		static bool read(const std::string& path, Journal& journal);
+	};
+
+	// journal the UI records into, nullptr when nothing is being recorded
+	Journal* getRecorder();
+	void setRecorder(Journal* journal);
+	void recordButton(const std::string& name);
+	void recordText(const std::string& name, const std::string& text);
+
+	struct Result {
+		uint32_t days;
+		uint32_t seasons;
+		uint64_t digest;
+		size_t firstDivergence; // index of the first ADVANCE_DAYS entry whose check didn't match, SIZE_MAX if none
+		double ms;
+
+		Result() : days(0), seasons(0), digest(0), firstDivergence(SIZE_MAX), ms(0.0) {}
+	};
+
+	// re-runs the journal without a window, as fast as the simulation goes
+	Result runHeadless(const Journal& journal);
+
+	void benchmark(uint32_t seasons = 20);
+}
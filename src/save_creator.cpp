@@ -1,2 +1,633 @@
+#include "save_creator.h"
+#include "save_index.h"
+#include "codec.h"
+#include "crc32c.h"
+#include "thread_pool.h"
+#include "logging.h"
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <chrono>
+#include <ctime>
+#include <random>
+#include <filesystem>
+#include <unordered_map>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
+SaveCreator::MappedFile::MappedFile(const std::string& path) : bytes(nullptr), length(0) {
+#ifdef _WIN32
+	this->mappingHandle = nullptr;
+	this->fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (this->fileHandle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Could not open " + path);
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx(this->fileHandle, &size);
+	this->length = (size_t)size.QuadPart;
+	if (this->length == 0) {
+		return;
+	}
+	this->mappingHandle = CreateFileMappingA(this->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!this->mappingHandle) {
+		CloseHandle(this->fileHandle);
+		throw std::runtime_error("Could not map " + path);
+	}
+	this->bytes = (const uint8_t*)MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (!this->bytes) {
+		CloseHandle(this->mappingHandle);
+		CloseHandle(this->fileHandle);
+		throw std::runtime_error("Could not map " + path);
+	}
+#else
+	this->fd = open(path.c_str(), O_RDONLY);
+	if (this->fd < 0) {
+		throw std::runtime_error("Could not open " + path);
+	}
+	struct stat info;
+	fstat(this->fd, &info);
+	this->length = (size_t)info.st_size;
+	if (this->length == 0) {
+		return;
+	}
+	void* mapped = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, this->fd, 0);
+	if (mapped == MAP_FAILED) {
+		close(this->fd);
+		throw std::runtime_error("Could not map " + path);
+	}
+	this->bytes = (const uint8_t*)mapped;
+#endif
+}
+
+SaveCreator::MappedFile::~MappedFile() {
+#ifdef _WIN32
+	if (this->bytes) UnmapViewOfFile(this->bytes);
+	if (this->mappingHandle) CloseHandle(this->mappingHandle);
+	CloseHandle(this->fileHandle);
+#else
+	if (this->bytes) munmap((void*)this->bytes, this->length);
+	close(this->fd);
+#endif
+}
+
+SaveCreator::Save::Save(const std::string& name, Modes::GameMode gameMode, Modes::EsportModes esportMode, Modes::SportModes sportMode, uint64_t seed) :
+	name(name), path(""), gameMode(gameMode), esportMode(esportMode), sportMode(sportMode), seed(seed), clubName(""), day(0), playSeconds(0), compressChunks(false) {}
+
+SaveCreator::SlotSummary SaveCreator::Save::summary() const {
+	SlotSummary res = {};
+	res.magic = summaryMagic;
+	res.day = this->day;
+	std::strncpy(res.saveName, this->name.c_str(), sizeof(res.saveName) - 1);
+	std::strncpy(res.clubName, this->clubName.c_str(), sizeof(res.clubName) - 1);
+	res.playSeconds = this->playSeconds;
+	res.savedAt = (int64_t)std::time(nullptr);
+	res.characters = (uint32_t)this->world.characters.personality.size();
+	res.clubs = (uint32_t)this->world.clubs.sheets.size();
+	res.gameMode = (uint8_t)this->gameMode;
+	res.esportMode = (uint8_t)this->esportMode;
+	res.sportMode = (uint8_t)this->sportMode;
+	res.checksum = checksum(&res, offsetof(SlotSummary, checksum));
+	return res;
+}
+
+void SaveCreator::Save::write(const std::string& path, uint64_t logSequence) {
+	// written next to the target and renamed over it, so a failed write leaves the old save intact
+	const std::string tempPath = path + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		throw std::runtime_error("Could not open " + tempPath);
+	}
+
+	FileHeader header = {};
+	std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+	header.version = formatVersion;
+	header.headerSize = sizeof(FileHeader) + sizeof(SlotSummary);
+	header.seed = this->seed;
+	header.logSequence = logSequence;
+	header.flags = this->compressChunks ? (uint32_t)COMPRESSED_CHUNKS : 0u;
+	header.gameMode = (uint8_t)this->gameMode;
+	header.esportMode = (uint8_t)this->esportMode;
+	header.sportMode = (uint8_t)this->sportMode;
+	std::strncpy(header.name, this->name.c_str(), sizeof(header.name) - 1);
+	SlotSummary summary = this->summary();
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)&summary, sizeof(summary));
+
+	static const char padding[chunkAlignment] = {};
+	uint64_t offset = header.headerSize;
+	auto align = [&]() {
+		uint64_t pad = (chunkAlignment - offset % chunkAlignment) % chunkAlignment;
+		file.write(padding, pad);
+		offset += pad;
+	};
+
+	std::vector<TocEntry> toc;
+	this->world.forEachColumn([&](uint32_t id, auto& column) {
+		// a chunk that failed its checksum would get a new one here and pass from then on
+		if (!column.verify()) {
+			throw std::runtime_error("A column failed its checksum, " + path + " isn't written over.");
+		}
+		align();
+		using T = typename std::decay_t<decltype(column)>::value_type;
+		TocEntry entry = { id, (uint32_t)sizeof(T), offset, (uint64_t)column.size() * sizeof(T), 0 };
+		if (this->compressChunks) {
+			std::vector<uint8_t> raw(entry.bytes);
+			column.copyTo(0, column.size(), (T*)raw.data());
+			std::vector<uint8_t> stored = compressChunk(raw.data(), raw.size());
+			entry.bytes = stored.size();
+			file.write((const char*)stored.data(), stored.size());
+		}
+		else {
+			std::vector<uint32_t> sums;
+			uint32_t crc = 0;
+			size_t pending = 0;
+			column.forEachChunk([&](const T* values, size_t count) {
+				file.write((const char*)values, count * sizeof(T));
+				while (count > 0) {
+					size_t take = std::min(count, checksumElements - pending);
+					crc = checksum(values, take * sizeof(T), crc);
+					values += take;
+					count -= take;
+					pending += take;
+					if (pending == checksumElements) {
+						sums.push_back(crc);
+						crc = 0;
+						pending = 0;
+					}
+				}
+			});
+			if (pending) {
+				sums.push_back(crc);
+			}
+			offset += entry.bytes;
+			align();
+			entry.checksumOffset = offset;
+			file.write((const char*)sums.data(), sums.size() * sizeof(uint32_t));
+			offset += sums.size() * sizeof(uint32_t);
+			toc.push_back(entry);
+			return;
+		}
+		offset += entry.bytes;
+		toc.push_back(entry);
+	});
+
+	align();
+	header.tocOffset = offset;
+	header.tocCount = (uint32_t)toc.size();
+	header.tocChecksum = checksum(toc.data(), toc.size() * sizeof(TocEntry));
+	header.headerChecksum = checksum(&header, offsetof(FileHeader, headerChecksum));
+	file.write((const char*)toc.data(), toc.size() * sizeof(TocEntry));
+	file.seekp(0);
+	file.write((const char*)&header, sizeof(header));
+	file.close();
+	if (!file) {
+		throw std::runtime_error("Failed to write " + tempPath);
+	}
+
+	flushToDisk(tempPath);
+	replaceFile(tempPath, path);
+	this->path = path;
+	this->written = generationMarks(this->world);
+	this->baseWriteTime = std::filesystem::last_write_time(path);
+}
+
+SaveCreator::Save* SaveCreator::Save::load(const std::string& path) {
+	restoreReplaced(path);
+	restoreReplaced(logPathFor(path));
+	auto mapped = std::make_shared<MappedFile>(path);
+	const uint8_t* bytes = mapped->data();
+
+	if (mapped->size() < sizeof(FileHeader)) {
+		throw std::runtime_error(path + " is not a save file.");
+	}
+	FileHeader header;
+	std::memcpy(&header, bytes, sizeof(header));
+	if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0) {
+		throw std::runtime_error(path + " is not a save file.");
+	}
+	if (header.version == 0 || header.version > formatVersion) {
+		throw std::runtime_error(path + " has unsupported save version " + std::to_string(header.version));
+	}
+	// header and table of contents are checked up front, chunk checksums once the world is checked
+	const bool legacy = header.version < 4;
+	const size_t entrySize = legacy ? legacyTocEntrySize : sizeof(TocEntry);
+	if (header.tocOffset > mapped->size() || (uint64_t)header.tocCount * entrySize > mapped->size() - header.tocOffset) {
+		throw std::runtime_error(path + " has a truncated table of contents.");
+	}
+	if (!legacy && (header.headerChecksum != checksum(&header, offsetof(FileHeader, headerChecksum))
+		|| header.tocChecksum != checksum(bytes + header.tocOffset, (size_t)header.tocCount * entrySize))) {
+		throw std::runtime_error(path + " failed its header checksum.");
+	}
+
+	std::unordered_map<uint32_t, TocEntry> toc;
+	for (uint32_t i = 0; i < header.tocCount; i++) {
+		TocEntry entry = {};
+		std::memcpy(&entry, bytes + header.tocOffset + i * entrySize, entrySize);
+		// written so a crafted size can't wrap around
+		if (entry.offset > mapped->size() || entry.bytes > mapped->size() - entry.offset || entry.offset % chunkAlignment != 0) {
+			throw std::runtime_error(path + " has a corrupt chunk entry.");
+		}
+		toc[entry.id] = entry;
+	}
+
+	Save* res = new Save();
+	res->name = std::string(header.name, strnlen(header.name, sizeof(header.name)));
+	res->path = path;
+	res->gameMode = (Modes::GameMode)header.gameMode;
+	res->esportMode = (Modes::EsportModes)header.esportMode;
+	res->sportMode = (Modes::SportModes)header.sportMode;
+	res->seed = header.seed;
+	res->compressChunks = header.version >= 3 && (header.flags & COMPRESSED_CHUNKS);
+	SlotSummary summary;
+	if (readSlotSummary(path, summary) && summary.magic == summaryMagic) {
+		res->clubName = std::string(summary.clubName, strnlen(summary.clubName, sizeof(summary.clubName)));
+		res->day = summary.day;
+		res->playSeconds = summary.playSeconds;
+	}
+
+	try {
+		// chunks this version doesn't know are skipped, missing ones load as empty columns
+		res->world.forEachColumn([&](uint32_t id, auto& column) {
+			auto it = toc.find(id);
+			if (it == toc.end()) {
+				return;
+			}
+			const size_t elementSize = sizeof(typename std::decay_t<decltype(column)>::value_type);
+			const uint8_t* chunk = bytes + it->second.offset;
+			uint64_t chunkBytes = it->second.bytes;
+			std::shared_ptr<const void> backing = mapped;
+			if (res->compressChunks) {
+				// decompressed once here, the columns then view the buffer just like a mapped chunk
+				std::shared_ptr<uint8_t[]> raw = decompressChunk(chunk, chunkBytes, chunkBytes, legacy);
+				backing = raw;
+				chunk = raw.get();
+			}
+			if (it->second.elementSize != elementSize || chunkBytes % elementSize != 0) {
+				throw std::runtime_error(path + " has a chunk with the wrong element size.");
+			}
+			const size_t elements = chunkBytes / elementSize;
+			const uint32_t* sums = nullptr;
+			if (it->second.checksumOffset) {
+				const uint64_t sumCount = (elements + checksumElements - 1) / checksumElements;
+				if (it->second.checksumOffset % chunkAlignment != 0 || it->second.checksumOffset > mapped->size()
+					|| sumCount * sizeof(uint32_t) > mapped->size() - it->second.checksumOffset) {
+					throw std::runtime_error(path + " has a corrupt checksum table.");
+				}
+				sums = (const uint32_t*)(bytes + it->second.checksumOffset);
+			}
+			column.mapTo(chunk, elements, backing, sums);
+		});
+	}
+	catch (...) {
+		delete res;
+		throw;
+	}
+	res->log = replayLog(res->world, logPathFor(path), header.logSequence);
+	if (!res->world.characters.names.valid() || !res->world.clubs.names.valid()) {
+		delete res;
+		throw std::runtime_error(path + " has a corrupt string column.");
+	}
+	res->written = generationMarks(res->world);
+	res->baseWriteTime = std::filesystem::last_write_time(path);
+	return res;
+}
+
+std::vector<uint8_t> SaveCreator::compressChunk(const uint8_t* raw, uint64_t rawBytes) {
+	const size_t blockCount = (size_t)((rawBytes + compressionBlockBytes - 1) / compressionBlockBytes);
+	std::vector<std::vector<uint8_t>> blocks(blockCount);
+	std::vector<BlockEntry> entries(blockCount);
+
+	Jobs::ThreadPool::getPool()->parallelFor(blockCount, [&](size_t i) {
+		const uint8_t* src = raw + i * compressionBlockBytes;
+		const size_t srcBytes = (size_t)std::min<uint64_t>(compressionBlockBytes, rawBytes - i * compressionBlockBytes);
+		std::vector<uint8_t>& block = blocks[i];
+		block.resize(Codec::compressBound(srcBytes));
+		size_t packed = Codec::compress(src, srcBytes, block.data(), block.size());
+
+		BlockEntry& entry = entries[i];
+		entry.rawBytes = (uint32_t)srcBytes;
+		entry.flags = 0;
+		if (packed == 0 || packed >= srcBytes) {
+			block.assign(src, src + srcBytes);
+			entry.flags = STORED_RAW;
+		}
+		else {
+			block.resize(packed);
+		}
+		entry.storedBytes = (uint32_t)block.size();
+		entry.checksum = checksum(block.data(), block.size());
+	});
+
+	BlockTableHeader table = { blockTableMagic, (uint32_t)blockCount, rawBytes };
+	size_t total = sizeof(table) + blockCount * sizeof(BlockEntry);
+	for (auto& block : blocks) {
+		total += block.size();
+	}
+	std::vector<uint8_t> res;
+	res.reserve(total);
+	res.insert(res.end(), (const uint8_t*)&table, (const uint8_t*)&table + sizeof(table));
+	res.insert(res.end(), (const uint8_t*)entries.data(), (const uint8_t*)entries.data() + entries.size() * sizeof(BlockEntry));
+	for (auto& block : blocks) {
+		res.insert(res.end(), block.begin(), block.end());
+	}
+	return res;
+}
+
+std::shared_ptr<uint8_t[]> SaveCreator::decompressChunk(const uint8_t* stored, uint64_t storedBytes, uint64_t& rawBytes, bool legacyChecksums) {
+	const auto sum = legacyChecksums ? legacyChecksum : checksum;
+	BlockTableHeader table;
+	if (storedBytes < sizeof(table)) {
+		throw std::runtime_error("Compressed chunk is truncated.");
+	}
+	std::memcpy(&table, stored, sizeof(table));
+	const uint64_t tableBytes = sizeof(table) + (uint64_t)table.blockCount * sizeof(BlockEntry);
+	if (table.magic != blockTableMagic || tableBytes > storedBytes
+		|| table.blockCount != (table.rawBytes + compressionBlockBytes - 1) / compressionBlockBytes) {
+		throw std::runtime_error("Compressed chunk has a corrupt block table.");
+	}
+
+	// block offsets are implied by the sizes before them
+	std::vector<BlockEntry> entries(table.blockCount);
+	std::vector<uint64_t> offsets(table.blockCount);
+	if (table.blockCount) {
+		std::memcpy(entries.data(), stored + sizeof(table), entries.size() * sizeof(BlockEntry));
+	}
+	uint64_t offset = tableBytes;
+	for (uint32_t i = 0; i < table.blockCount; i++) {
+		const uint64_t expectedRaw = std::min<uint64_t>(compressionBlockBytes, table.rawBytes - i * compressionBlockBytes);
+		if (entries[i].rawBytes != expectedRaw || offset + entries[i].storedBytes > storedBytes) {
+			throw std::runtime_error("Compressed chunk has a corrupt block table.");
+		}
+		offsets[i] = offset;
+		offset += entries[i].storedBytes;
+	}
+
+	std::shared_ptr<uint8_t[]> res(new uint8_t[std::max<uint64_t>(table.rawBytes, 1)]);
+	std::atomic<bool> corrupt(false);
+	Jobs::ThreadPool::getPool()->parallelFor(table.blockCount, [&](size_t i) {
+		const BlockEntry& entry = entries[i];
+		const uint8_t* src = stored + offsets[i];
+		uint8_t* dst = res.get() + i * compressionBlockBytes;
+		if (sum(src, entry.storedBytes, 0) != entry.checksum) {
+			corrupt = true;
+		}
+		else if (entry.flags & STORED_RAW) {
+			if (entry.storedBytes != entry.rawBytes) {
+				corrupt = true;
+			}
+			else {
+				std::memcpy(dst, src, entry.rawBytes);
+			}
+		}
+		else if (!Codec::decompress(src, entry.storedBytes, dst, entry.rawBytes)) {
+			corrupt = true;
+		}
+	});
+	if (corrupt) {
+		throw std::runtime_error("Compressed chunk failed its block checksum.");
+	}
+	rawBytes = table.rawBytes;
+	return res;
+}
+
+SaveCreator::Autosaver::Autosaver() : busy(false), succeeded(false), lastStallMs(0.0), lastWriteMs(0.0),
+	trackedSave(nullptr), trackedPath(""), baseBytes(0), deltas(0), pendingBaseBytes(0), pendingCompaction(false) {}
+
+SaveCreator::Autosaver::~Autosaver() {
+	this->wait();
+}
+
+void SaveCreator::Autosaver::wait() {
+	if (this->worker.joinable()) {
+		this->worker.join();
+		this->collectResult();
+	}
+}
+
+void SaveCreator::Autosaver::reset() {
+	this->wait();
+	this->trackedSave = nullptr;
+	this->trackedPath.clear();
+}
+
+void SaveCreator::Autosaver::collectResult() {
+	if (!this->succeeded.exchange(false)) {
+		return;
+	}
+	this->log = this->pendingLog;
+	this->saved = std::move(this->pendingSaved);
+	if (this->pendingCompaction) {
+		this->baseBytes = this->pendingBaseBytes;
+		this->baseWriteTime = this->pendingBaseWriteTime;
+		this->deltas = 0;
+	}
+	else {
+		this->deltas++;
+	}
+}
+
+bool SaveCreator::Autosaver::filesMatch(const std::string& path) const {
+	std::error_code error;
+	if (!std::filesystem::exists(path, error) || std::filesystem::last_write_time(path, error) != this->baseWriteTime || error) {
+		return false;
+	}
+	const std::string logPath = logPathFor(path);
+	const uint64_t logBytes = std::filesystem::exists(logPath, error) ? std::filesystem::file_size(logPath, error) : 0;
+	return !error && logBytes == this->log.bytes;
+}
+
+bool SaveCreator::Autosaver::autosave(const Save& save, const std::string& path) {
+	if (this->busy.load()) {
+		DEBUG("Autosave skipped, the previous one is still being written.");
+		return false;
+	}
+	this->wait();
+
+	auto start = std::chrono::steady_clock::now();
+
+	bool appendable = this->baseBytes != 0;
+	if (&save != this->trackedSave || path != this->trackedPath) {
+		// a save loaded from this path already knows its log, anything else starts with a full write
+		this->trackedSave = &save;
+		this->trackedPath = path;
+		this->deltas = 0;
+		const bool loaded = save.path == path;
+		this->log = loaded ? save.log : LogState();
+		this->baseWriteTime = loaded ? save.baseWriteTime : std::filesystem::file_time_type();
+		// a log in an older version can't take new records, the first autosave compacts it away
+		appendable = loaded && save.log.version == logVersion;
+		this->saved = appendable ? save.written : GenerationMarks();
+	}
+	// the marks only describe the files as they were last written or loaded here
+	if (!this->filesMatch(path)) {
+		this->log = LogState();
+		this->saved = GenerationMarks();
+		appendable = false;
+	}
+	this->baseBytes = appendable ? std::filesystem::file_size(path) : 0;
+
+	Save* snapshot = save.snapshot();
+	this->pendingSaved = generationMarks(snapshot->world);
+	this->pendingCompaction = this->baseBytes == 0 || this->deltas >= maxDeltas
+		|| (double)this->log.bytes > (double)this->baseBytes * compactionRatio;
+
+	const bool compaction = this->pendingCompaction;
+	const LogState log = this->log;
+	const GenerationMarks saved = compaction ? GenerationMarks() : this->saved;
+
+	// stored before the worker starts, it reports this run's stall
+	this->lastStallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	this->busy = true;
+	this->worker = std::thread([this, snapshot, path, compaction, log, saved]() {
+		auto writeStart = std::chrono::steady_clock::now();
+		try {
+			if (compaction) {
+				// the new base records the log's last commit, so a crash before the reset can't replay it twice
+				snapshot->write(path, log.sequence);
+				resetLog(logPathFor(path));
+				this->pendingLog = LogState(log.sequence, logHeaderSize);
+				this->pendingBaseBytes = std::filesystem::file_size(path);
+				this->pendingBaseWriteTime = std::filesystem::last_write_time(path);
+			}
+			else {
+				this->pendingLog = appendDelta(snapshot->world, logPathFor(path), saved, log);
+			}
+			writeSummarySidecar(path, snapshot->summary());
+			this->succeeded = true;
+		}
+		catch (std::exception& e) {
+			ERROR("Autosave failed. " << e.what());
+		}
+		delete snapshot;
+		this->lastWriteMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - writeStart).count();
+		LOG("Autosave (" << (compaction ? "compaction" : "delta") << ") written in " << this->lastWriteMs.load()
+			<< " ms, main thread stalled " << this->lastStallMs.load() << " ms");
+		this->busy = false;
+	});
+	return true;
+}
+
+void SaveCreator::benchmark(size_t characters) {
+	std::mt19937 rng(1);
+	Save save("benchmark", Modes::SPORT, Modes::NONE_ESPORT, Modes::HANDBALL, 1);
+	World::WorldState& world = save.world;
+
+	for (uint16_t c = 0; c < 400; c++) {
+		world.addClub("Club " + std::to_string(c), Match::TeamSheet(), c / 20);
+	}
+	for (size_t i = 0; i < characters; i++) {
+		world.characters.names.add("Player " + std::to_string(i));
+		world.characters.personality.push_back((uint8_t)(rng() % Traits::PERSONALITY_NONE));
+		// a few bits per category, like packTraits produces for generated characters
+		uint64_t traits = 0;
+		for (uint8_t k = 0; k < CharacterConfig::numberOfTraits; k++) {
+			traits |= 1ull << (World::emotionBits + rng() % Traits::EMOTION_NONE);
+			traits |= 1ull << (World::motivationBits + rng() % Traits::MOTIVATION_NONE);
+			traits |= 1ull << (World::moralityBits + rng() % Traits::MORALITY_NONE);
+			traits |= 1ull << (World::intelligenceBits + rng() % Traits::INTELLIGENCE_NONE);
+			traits |= 1ull << (World::backgroundBits + rng() % Traits::BACKGROUND_NONE);
+		}
+		world.characters.traits.push_back(traits);
+		world.characters.club.push_back((uint16_t)(rng() % 400));
+	}
+
+	const std::string path = "benchmark.sav";
+	auto start = std::chrono::steady_clock::now();
+	save.write(path);
+	auto written = std::chrono::steady_clock::now();
+	Save* loaded = Save::load(path);
+	auto end = std::chrono::steady_clock::now();
+
+	bool matches = loaded->world.characters.traits.size() == characters
+		&& loaded->world.characters.traits[characters / 2] == world.characters.traits[characters / 2]
+		&& loaded->world.characters.names.get(characters - 1) == world.characters.names.get(characters - 1);
+
+	LOG("Save with " << characters << " characters (" << std::filesystem::file_size(path) / (1024 * 1024) << " MB): write "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(written - start).count() << " ms, load "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(end - written).count() / 1000.0 << " ms"
+		<< (matches ? "" : ", loaded data doesn't match"));
+
+	// loading only checked the header, this is what a full pass over the chunk checksums costs
+	auto verifyStart = std::chrono::steady_clock::now();
+	bool intact = loaded->world.verify();
+	auto verifyEnd = std::chrono::steady_clock::now();
+	LOG("CRC32C (" << (Crc32c::hardwareAccelerated() ? "SSE4.2" : "slicing-by-8") << ") over every chunk took "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(verifyEnd - verifyStart).count() / 1000.0 << " ms"
+		<< (intact ? "" : ", the file is corrupt"));
+
+	// edits after the snapshot must not reach the autosaved file
+	Autosaver autosaver;
+	autosaver.autosave(save, path);
+	world.characters.traits.set(0, ~world.characters.traits[0]);
+	autosaver.wait();
+	Save* autosaved = Save::load(path);
+	LOG("Autosave stalled the caller for " << autosaver.getLastStallMs() << " ms, serializing took " << autosaver.getLastWriteMs() << " ms"
+		<< (autosaved->world.characters.traits[0] == loaded->world.characters.traits[0] ? "" : ", snapshot saw a later edit"));
+
+	// a handful of edits only costs the chunks they touched
+	autosaver.autosave(save, path);
+	autosaver.wait();
+	for (size_t i = 0; i < 100; i++) {
+		world.characters.club.set(rng() % characters, (uint16_t)(rng() % 400));
+	}
+	autosaver.autosave(save, path);
+	autosaver.wait();
+	Save* replayed = Save::load(path);
+	bool replayMatches = true;
+	for (size_t i = 0; i < characters && replayMatches; i += 997) {
+		replayMatches = replayed->world.characters.club[i] == world.characters.club[i];
+	}
+	LOG("Delta autosave took " << autosaver.getLastWriteMs() << " ms, log is " << std::filesystem::file_size(logPathFor(path)) / 1024 << " KB"
+		<< (replayMatches ? "" : ", replayed data doesn't match"));
+
+	// the block codec on its own, then the same world as a compressed save
+	std::vector<uint8_t> raw;
+	world.forEachColumn([&](uint32_t, auto& column) {
+		using T = typename std::decay_t<decltype(column)>::value_type;
+		column.forEachChunk([&](const T* values, size_t count) {
+			raw.insert(raw.end(), (const uint8_t*)values, (const uint8_t*)(values + count));
+		});
+	});
+	auto packStart = std::chrono::steady_clock::now();
+	std::vector<uint8_t> packed = compressChunk(raw.data(), raw.size());
+	auto packEnd = std::chrono::steady_clock::now();
+	uint64_t unpackedBytes = 0;
+	std::shared_ptr<uint8_t[]> unpacked = decompressChunk(packed.data(), packed.size(), unpackedBytes);
+	auto unpackEnd = std::chrono::steady_clock::now();
+	const double gigabytes = (double)raw.size() / 1e9;
+	LOG("Block codec on " << raw.size() / (1024 * 1024) << " MB of save data with " << Jobs::ThreadPool::getPool()->size() << " threads: ratio "
+		<< (double)raw.size() / (double)packed.size() << ", compress " << gigabytes / std::chrono::duration<double>(packEnd - packStart).count()
+		<< " GB/s, decompress " << gigabytes / std::chrono::duration<double>(unpackEnd - packEnd).count() << " GB/s"
+		<< (unpackedBytes == raw.size() && std::memcmp(unpacked.get(), raw.data(), raw.size()) == 0 ? "" : ", round trip doesn't match"));
+
+	const std::string packedPath = "benchmark_packed.sav";
+	save.compressChunks = true;
+	start = std::chrono::steady_clock::now();
+	save.write(packedPath);
+	written = std::chrono::steady_clock::now();
+	Save* packedLoad = Save::load(packedPath);
+	end = std::chrono::steady_clock::now();
+	bool packedMatches = packedLoad->world.characters.traits[characters / 3] == world.characters.traits[characters / 3]
+		&& packedLoad->world.characters.names.get(characters - 1) == world.characters.names.get(characters - 1);
+	LOG("Compressed save (" << std::filesystem::file_size(packedPath) / (1024 * 1024) << " MB): write "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(written - start).count() << " ms, load "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(end - written).count() / 1000.0 << " ms"
+		<< (packedMatches ? "" : ", loaded data doesn't match"));
+
+	delete packedLoad;
+	delete replayed;
+	delete autosaved;
+	delete loaded;
+	std::filesystem::remove(path);
+	std::filesystem::remove(logPathFor(path));
+	std::filesystem::remove(packedPath);
+}
@@ -1,29 +1,229 @@
 #pragma once
 
-namespace Modes {
-	enum GameMode {
-		E_SPORT,
-		SPORT
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <filesystem>
+#include "modes.h"
+#include "world.h"
+#include "save_log.h"
+
+namespace SaveCreator {
+	constexpr char fileMagic[8] = { 'M', 'G', 'R', 'S', 'A', 'V', 'E', '\0' };
+	constexpr uint32_t formatVersion = 4; // 3 and older used FNV-1a and had no per-chunk checksums
+	constexpr uint64_t chunkAlignment = 64;
+
+	enum FileFlags : uint32_t {
+		COMPRESSED_CHUNKS = 1 // version 3+
 	};
 
-	enum EsportModes {
-		MOBA,
-		SHOOTER,
-		NONE_ESPORT
+	/*
+	* File layout: header, column chunks (each aligned to chunkAlignment), table of contents.
+	* Every chunk is the raw bytes of one World column, so a loaded save maps the file and
+	* points the columns straight into it.
+	*/
+	struct FileHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		uint64_t tocOffset;
+		uint32_t tocCount;
+		uint32_t flags;
+		uint64_t seed;
+		uint8_t gameMode;
+		uint8_t esportMode;
+		uint8_t sportMode;
+		uint8_t reserved0[5];
+		char name[64];
+		uint64_t logSequence; // delta log commits up to this one are already in the file
+		uint32_t tocChecksum; // version 4+
+		uint32_t headerChecksum; // covers every field above, version 4+
 	};
+	static_assert(sizeof(FileHeader) == 128, "The header layout is part of the file format.");
 
-	enum SportModes {
-		FOOTBALL,
-		BASKETBALL,
-		HANDBALL,
-		NONE_SPORT
+	/*
+	* Everything the saves menu shows, at a fixed offset right after the header (version 2+).
+	* Delta autosaves don't touch the base file, so they mirror the current summary into a
+	* small "<save>.meta" sidecar instead.
+	*/
+	struct SlotSummary {
+		uint32_t magic;
+		uint32_t day;
+		char saveName[64];
+		char clubName[64];
+		uint64_t playSeconds;
+		int64_t savedAt; // unix time
+		uint32_t characters;
+		uint32_t clubs;
+		uint8_t gameMode;
+		uint8_t esportMode;
+		uint8_t sportMode;
+		uint8_t reserved0[1];
+		uint8_t reserved1[88];
+		uint32_t checksum; // covers every field above
+	};
+	static_assert(sizeof(SlotSummary) == 256, "The summary layout is part of the file format.");
+	constexpr uint32_t summaryMagic = World::chunkId("SUMM");
+	constexpr uint64_t summaryOffset = sizeof(FileHeader);
+
+	/*
+	* Uncompressed chunks (version 4+) are followed by one CRC32C per checksumElements
+	* elements, at checksumOffset. Compressed chunks are covered by their block checksums.
+	*/
+	constexpr size_t checksumElements = World::Column<uint8_t>::chunkElements;
+
+	struct TocEntry {
+		uint32_t id;
+		uint32_t elementSize;
+		uint64_t offset;
+		uint64_t bytes;
+		uint64_t checksumOffset; // 0 when there is no checksum table, version 4+
+	};
+	static_assert(sizeof(TocEntry) == 32, "The table of contents layout is part of the file format.");
+	constexpr size_t legacyTocEntrySize = 24; // version 3 and older
+
+	/*
+	* A compressed chunk is a block table followed by the blocks back to back. Every block holds
+	* up to compressionBlockBytes of the column's raw bytes and is compressed, checked and
+	* decompressed on its own, so both directions spread over the job pool.
+	*/
+	constexpr uint64_t compressionBlockBytes = 1 << 17;
+	constexpr uint32_t blockTableMagic = World::chunkId("BLKS");
+
+	struct BlockTableHeader {
+		uint32_t magic;
+		uint32_t blockCount;
+		uint64_t rawBytes;
+	};
+	static_assert(sizeof(BlockTableHeader) == 16, "The block table layout is part of the file format.");
+
+	enum BlockFlags : uint32_t {
+		STORED_RAW = 1 // didn't shrink, kept as is
+	};
+
+	struct BlockEntry {
+		uint32_t storedBytes;
+		uint32_t rawBytes;
+		uint32_t checksum; // of the stored bytes
+		uint32_t flags;
+	};
+	static_assert(sizeof(BlockEntry) == 16, "The block table layout is part of the file format.");
+
+	// read-only memory mapping of a whole file, it can still be renamed and replaced while mapped (see replaceFile)
+	class MappedFile {
+	private:
+		const uint8_t* bytes;
+		size_t length;
+#ifdef _WIN32
+		void* fileHandle;
+		void* mappingHandle;
+#else
+		int fd;
+#endif
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+	public:
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+
+		const uint8_t* data() const { return this->bytes; }
+		size_t size() const { return this->length; }
 	};
-}
 
-namespace SaveCreator {
 	class Save {
+	private:
 		Save() = default;
-		Save(Modes::GameMode gameMode, Modes::EsportModes esportMode, Modes::SportModes sportMode);
+	public:
+		std::string name;
+		std::string path;
+		Modes::GameMode gameMode;
+		Modes::EsportModes esportMode;
+		Modes::SportModes sportMode;
+		uint64_t seed;
+		std::string clubName;
+		uint32_t day;
+		uint64_t playSeconds;
+		bool compressChunks; // kept from the loaded file, delta logs are never compressed
+		LogState log;
+		GenerationMarks written; // column generations of the last full write or load
+		// of the base file at that point, log and written only describe the files while it's unchanged
+		std::filesystem::file_time_type baseWriteTime;
+
+		World::WorldState world;
+
+		Save(const std::string& name, Modes::GameMode gameMode, Modes::EsportModes esportMode, Modes::SportModes sportMode, uint64_t seed);
 		~Save() = default;
+
+		void write(const std::string& path, uint64_t logSequence = 0);
+		// maps the base file and replays the committed part of its delta log on top
+		static Save* load(const std::string& path);
+
+		SlotSummary summary() const;
+
+		// shares every column chunk with this save, edits made afterwards don't show up in it
+		Save* snapshot() const { return new Save(*this); }
+	};
+
+	/*
+	* Writes saves on a background thread. The main thread only pays for the snapshot, the
+	* serializer works on that snapshot while the game keeps changing the world. Usually only
+	* the chunks that changed are appended to the delta log; the log is compacted into a new
+	* base file once it grows past compactionRatio of the base or maxDeltas appends.
+	*/
+	class Autosaver {
+	private:
+		std::thread worker;
+		std::atomic<bool> busy;
+		std::atomic<bool> succeeded;
+		std::atomic<double> lastStallMs;
+		std::atomic<double> lastWriteMs;
+
+		// only touched by the main thread, results of a write are taken over once it succeeded
+		const Save* trackedSave;
+		std::string trackedPath;
+		LogState log;
+		uint64_t baseBytes;
+		std::filesystem::file_time_type baseWriteTime;
+		uint32_t deltas;
+		GenerationMarks saved;
+
+		LogState pendingLog;
+		uint64_t pendingBaseBytes;
+		std::filesystem::file_time_type pendingBaseWriteTime;
+		GenerationMarks pendingSaved;
+		bool pendingCompaction;
+
+		void collectResult();
+		// false once anything but this autosaver wrote the base file or the log
+		bool filesMatch(const std::string& path) const;
+
+		Autosaver(const Autosaver&) = delete;
+		Autosaver& operator=(const Autosaver&) = delete;
+	public:
+		static constexpr double compactionRatio = 0.5;
+		static constexpr uint32_t maxDeltas = 64;
+
+		Autosaver();
+		~Autosaver();
+
+		// returns false when the previous autosave is still being written
+		bool autosave(const Save& save, const std::string& path);
+		void wait();
+		// forgets the save it wrote last, for when another one replaces it, even at the same address
+		void reset();
+
+		bool isBusy() const { return this->busy.load(); }
+		double getLastStallMs() const { return this->lastStallMs.load(); }
+		double getLastWriteMs() const { return this->lastWriteMs.load(); }
 	};
-}
\ No newline at end of file
+
+	std::vector<uint8_t> compressChunk(const uint8_t* raw, uint64_t rawBytes);
+	// returns the raw bytes, throws when a block is corrupt
+	std::shared_ptr<uint8_t[]> decompressChunk(const uint8_t* stored, uint64_t storedBytes, uint64_t& rawBytes, bool legacyChecksums = false);
+
+	void benchmark(size_t characters = 1000000);
+}
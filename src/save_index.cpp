@@ -0,0 +1,193 @@
+#include "save_index.h"
+#include "calendar.h"
+#include "logging.h"
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+namespace SaveCreator {
+	// sidecars don't carry a version, ones written before format 4 use the legacy checksum
+	static bool validSummary(const SlotSummary& summary) {
+		const size_t covered = offsetof(SlotSummary, checksum);
+		return summary.magic == summaryMagic
+			&& (summary.checksum == checksum(&summary, covered) || summary.checksum == legacyChecksum(&summary, covered));
+	}
+}
+
+void SaveCreator::writeSummarySidecar(const std::string& savePath, const SlotSummary& summary) {
+	const std::string path = summaryPathFor(savePath);
+	const std::string tempPath = path + ".tmp";
+	std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+	file.write((const char*)&summary, sizeof(summary));
+	file.close();
+	if (!file) {
+		throw std::runtime_error("Failed to write " + tempPath);
+	}
+	std::filesystem::rename(tempPath, path);
+}
+
+void SaveCreator::writeThumbnail(const std::string& savePath, const sf::Image& frame) {
+	const sf::Vector2u from = frame.getSize();
+	if (from.x < thumbnailWidth || from.y < thumbnailHeight) {
+		return;
+	}
+
+	// every thumbnail pixel is the average of the box of frame pixels it covers
+	const uint8_t* pixels = frame.getPixelsPtr();
+	sf::Image thumbnail({ thumbnailWidth, thumbnailHeight });
+	for (unsigned int y = 0; y < thumbnailHeight; y++) {
+		const unsigned int top = y * from.y / thumbnailHeight;
+		const unsigned int bottom = (y + 1) * from.y / thumbnailHeight;
+		for (unsigned int x = 0; x < thumbnailWidth; x++) {
+			const unsigned int left = x * from.x / thumbnailWidth;
+			const unsigned int right = (x + 1) * from.x / thumbnailWidth;
+			uint32_t sum[4] = {};
+			for (unsigned int sy = top; sy < bottom; sy++) {
+				const uint8_t* row = pixels + ((size_t)sy * from.x + left) * 4;
+				for (unsigned int sx = left; sx < right; sx++, row += 4) {
+					for (int c = 0; c < 4; c++) {
+						sum[c] += row[c];
+					}
+				}
+			}
+			const uint32_t count = (bottom - top) * (right - left);
+			thumbnail.setPixel({ x, y }, sf::Color((uint8_t)(sum[0] / count), (uint8_t)(sum[1] / count), (uint8_t)(sum[2] / count), 255));
+		}
+	}
+
+	// the format follows the extension, so the temporary file keeps it
+	const std::string path = thumbnailPathFor(savePath);
+	const std::string tempPath = savePath + ".tmp.png";
+	if (!thumbnail.saveToFile(tempPath)) {
+		throw std::runtime_error("Failed to write " + tempPath);
+	}
+	std::filesystem::rename(tempPath, path);
+}
+
+bool SaveCreator::readSlotSummary(const std::string& savePath, SlotSummary& summary) {
+	std::ifstream file(savePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	uint8_t bytes[sizeof(FileHeader) + sizeof(SlotSummary)] = {};
+	file.read((char*)bytes, sizeof(bytes));
+	FileHeader header;
+	std::memcpy(&header, bytes, sizeof(header));
+	if (file.gcount() < (std::streamsize)sizeof(FileHeader) || std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0) {
+		return false;
+	}
+
+	bool found = false;
+	if (header.headerSize >= summaryOffset + sizeof(SlotSummary) && file.gcount() == (std::streamsize)sizeof(bytes)) {
+		std::memcpy(&summary, bytes + summaryOffset, sizeof(summary));
+		found = validSummary(summary);
+	}
+	if (!found) {
+		// version 1 saves only have the header
+		summary = {};
+		std::memcpy(summary.saveName, header.name, sizeof(summary.saveName));
+		summary.gameMode = header.gameMode;
+		summary.esportMode = header.esportMode;
+		summary.sportMode = header.sportMode;
+	}
+
+	// delta autosaves only update the sidecar
+	std::ifstream sidecar(summaryPathFor(savePath), std::ios::binary);
+	SlotSummary latest;
+	if (sidecar && sidecar.read((char*)&latest, sizeof(latest)) && validSummary(latest) && latest.savedAt >= summary.savedAt) {
+		summary = latest;
+	}
+	return true;
+}
+
+std::string SaveCreator::Slot::describe() const {
+	static const char* sportNames[] = { "Football", "Basketball", "Handball", "" };
+	static const char* esportNames[] = { "MOBA", "Shooter", "" };
+	const char* mode = this->summary.gameMode == Modes::SPORT
+		? sportNames[std::min<uint8_t>(this->summary.sportMode, Modes::NONE_SPORT)]
+		: esportNames[std::min<uint8_t>(this->summary.esportMode, Modes::NONE_ESPORT)];
+
+	std::string res = std::string(this->summary.saveName, strnlen(this->summary.saveName, sizeof(this->summary.saveName)));
+	std::string club = std::string(this->summary.clubName, strnlen(this->summary.clubName, sizeof(this->summary.clubName)));
+	if (!club.empty()) {
+		res += " - " + club;
+	}
+	res += " - " + Calendar::dayToDate(this->summary.day).toString();
+	res += " - " + std::string(mode);
+	res += " - " + std::to_string(this->summary.playSeconds / 3600) + "h " + std::to_string(this->summary.playSeconds / 60 % 60) + "m";
+	return res;
+}
+
+SaveCreator::SaveIndex::~SaveIndex() {
+	this->wait();
+}
+
+void SaveCreator::SaveIndex::wait() {
+	if (this->worker.joinable()) {
+		this->worker.join();
+	}
+}
+
+void SaveCreator::SaveIndex::scan(const std::string& directory) {
+	this->wait();
+	this->ready = false;
+
+	this->worker = std::thread([this, directory]() {
+		auto start = std::chrono::steady_clock::now();
+		std::vector<Slot> found;
+
+		try {
+			if (std::filesystem::is_directory(directory)) {
+				// a save whose write was cut off between replaceFile's renames is only there as an aside file
+				std::vector<std::string> interrupted;
+				for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+					const std::string name = entry.path().string();
+					const size_t aside = name.rfind(std::string(saveExtension) + ".old");
+					if (aside != std::string::npos) {
+						interrupted.push_back(name.substr(0, aside + std::strlen(saveExtension)));
+					}
+				}
+				for (const auto& path : interrupted) {
+					restoreReplaced(path);
+				}
+				for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+					if (!entry.is_regular_file() || entry.path().extension() != saveExtension) {
+						continue;
+					}
+					Slot slot;
+					slot.path = entry.path().string();
+					if (!readSlotSummary(slot.path, slot.summary)) {
+						continue;
+					}
+					// a few KB of PNG, decoded here so the menu only has to upload it
+					auto thumbnail = std::make_shared<sf::Image>();
+					if (std::filesystem::exists(thumbnailPathFor(slot.path)) && thumbnail->loadFromFile(thumbnailPathFor(slot.path))) {
+						slot.thumbnail = thumbnail;
+					}
+					found.push_back(slot);
+				}
+			}
+		}
+		catch (const std::filesystem::filesystem_error& e) {
+			ERROR("Error: " << e.what());
+		}
+
+		std::sort(found.begin(), found.end(), [](const Slot& a, const Slot& b) { return a.summary.savedAt > b.summary.savedAt; });
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			this->slots = std::move(found);
+		}
+		this->lastScanMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		DEBUG("Indexed " << this->slots.size() << " saves in " << this->lastScanMs.load() << " ms");
+		this->ready = true;
+	});
+}
+
+std::vector<SaveCreator::Slot> SaveCreator::SaveIndex::getSlots() {
+	std::lock_guard<std::mutex> guard(this->lock);
+	return this->slots;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "save_creator.h"
+#include "../include/SFML/Graphics/Image.hpp"
+
+namespace SaveCreator {
+	inline std::string summaryPathFor(const std::string& savePath) { return savePath + ".meta"; }
+
+	inline std::string thumbnailPathFor(const std::string& savePath) { return savePath + ".png"; }
+
+	constexpr unsigned int thumbnailWidth = 96;
+	constexpr unsigned int thumbnailHeight = 54;
+
+	void writeSummarySidecar(const std::string& savePath, const SlotSummary& summary);
+	// scales a captured frame down to the slot thumbnail and writes it next to the save
+	void writeThumbnail(const std::string& savePath, const sf::Image& frame);
+
+	// reads the header summary and the sidecar, a few hundred bytes per slot whatever the save size
+	bool readSlotSummary(const std::string& savePath, SlotSummary& summary);
+
+	struct Slot {
+		std::string path;
+		SlotSummary summary;
+		std::shared_ptr<const sf::Image> thumbnail; // null when the save has none
+
+		std::string describe() const;
+	};
+
+	/*
+	* Builds the saves menu's slot list on a background thread, newest save first, thumbnails
+	* included. The menu can show a placeholder until isReady() turns true.
+	*/
+	class SaveIndex {
+	private:
+		std::thread worker;
+		std::mutex lock;
+		std::vector<Slot> slots;
+		std::atomic<bool> ready;
+		std::atomic<double> lastScanMs;
+
+		SaveIndex(const SaveIndex&) = delete;
+		SaveIndex& operator=(const SaveIndex&) = delete;
+	public:
+		static constexpr const char* saveExtension = ".sav";
+
+		SaveIndex() : ready(false), lastScanMs(0.0) {}
+		~SaveIndex();
+
+		void scan(const std::string& directory);
+		void wait();
+
+		bool isReady() const { return this->ready.load(); }
+		double getLastScanMs() const { return this->lastScanMs.load(); }
+		std::vector<Slot> getSlots();
+	};
+}
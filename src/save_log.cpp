@@ -0,0 +1,321 @@
+#include "save_log.h"
+#include "save_creator.h"
+#include "logging.h"
+#include "crc32c.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+uint32_t SaveCreator::checksum(const void* data, size_t bytes, uint32_t seed) {
+	return Crc32c::compute(data, bytes, seed);
+}
+
+uint32_t SaveCreator::legacyChecksum(const void* data, size_t bytes, uint32_t seed) {
+	uint32_t hash = 2166136261u ^ seed;
+	const uint8_t* p = (const uint8_t*)data;
+	for (size_t i = 0; i < bytes; i++) {
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+void SaveCreator::flushToDisk(const std::string& path) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file != INVALID_HANDLE_VALUE) {
+		FlushFileBuffers(file);
+		CloseHandle(file);
+	}
+#else
+	int fd = open(path.c_str(), O_RDWR);
+	if (fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+#endif
+}
+
+void SaveCreator::replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+	if (MoveFileExW(std::filesystem::path(from).c_str(), std::filesystem::path(to).c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		return;
+	}
+	// a file with a mapped view can't be replaced or deleted, but since every mapping shares
+	// delete access it can be renamed, and the view follows it to the new name. A crash between
+	// the two renames leaves only the aside file, restoreReplaced puts it back
+	std::error_code ignored;
+	if (std::filesystem::exists(to)) {
+		std::string aside;
+		for (uint32_t i = 0; ; i++) {
+			aside = to + ".old" + (i ? std::to_string(i) : "");
+			// one left over from an earlier replace goes once nothing maps it anymore
+			std::filesystem::remove(aside, ignored);
+			if (!std::filesystem::exists(aside)) {
+				break;
+			}
+			if (i == 15) {
+				throw std::runtime_error("Could not move " + to + " aside.");
+			}
+		}
+		std::filesystem::rename(to, aside);
+		std::filesystem::rename(from, to);
+		std::filesystem::remove(aside, ignored);
+		return;
+	}
+#endif
+	std::filesystem::rename(from, to);
+}
+
+void SaveCreator::restoreReplaced(const std::string& path) {
+	std::error_code error;
+	if (std::filesystem::exists(path, error) || error) {
+		return;
+	}
+	const std::filesystem::path target(path);
+	const std::string prefix = target.filename().string() + ".old";
+	std::filesystem::path newest;
+	std::filesystem::file_time_type newestTime;
+	for (const auto& entry : std::filesystem::directory_iterator(target.parent_path().empty() ? "." : target.parent_path(), error)) {
+		const std::string name = entry.path().filename().string();
+		if (name.compare(0, prefix.size(), prefix) != 0 || name.find_first_not_of("0123456789", prefix.size()) != std::string::npos) {
+			continue;
+		}
+		const auto time = entry.last_write_time(error);
+		if (!error && (newest.empty() || time > newestTime)) {
+			newest = entry.path();
+			newestTime = time;
+		}
+	}
+	if (!newest.empty()) {
+		std::filesystem::rename(newest, target, error);
+		if (!error) {
+			LOG("Restored " << path << " from " << newest.string() << " after an interrupted write.");
+		}
+	}
+}
+
+namespace SaveCreator {
+	using ChecksumFn = uint32_t(*)(const void*, size_t, uint32_t);
+
+	static uint32_t headerChecksum(const RecordHeader& header, ChecksumFn sum = checksum) {
+		return sum(&header, offsetof(RecordHeader, headerChecksum), 0);
+	}
+
+	static uint64_t paddedSize(uint64_t bytes) {
+		return (bytes + chunkAlignment - 1) / chunkAlignment * chunkAlignment;
+	}
+
+	static void truncateLog(const std::string& logPath, uint64_t bytes) {
+		const std::string tempPath = logPath + ".tmp";
+		FILE* source = std::fopen(logPath.c_str(), "rb");
+		if (!source) {
+			throw std::runtime_error("Could not open " + logPath);
+		}
+		FILE* file = std::fopen(tempPath.c_str(), "wb");
+		if (!file) {
+			std::fclose(source);
+			throw std::runtime_error("Could not open " + tempPath);
+		}
+		std::vector<uint8_t> buffer(1 << 16);
+		bool ok = true;
+		for (uint64_t left = bytes; ok && left > 0;) {
+			size_t take = (size_t)std::min<uint64_t>(left, buffer.size());
+			ok = std::fread(buffer.data(), 1, take, source) == take && std::fwrite(buffer.data(), 1, take, file) == take;
+			left -= take;
+		}
+		std::fclose(source);
+		ok = std::fclose(file) == 0 && ok;
+		if (!ok) {
+			throw std::runtime_error("Failed to truncate " + logPath);
+		}
+		flushToDisk(tempPath);
+		replaceFile(tempPath, logPath);
+	}
+}
+
+SaveCreator::GenerationMarks SaveCreator::generationMarks(World::WorldState& world) {
+	GenerationMarks marks;
+	world.forEachColumn([&](uint32_t id, auto& column) {
+		marks[id] = column.getGeneration();
+	});
+	return marks;
+}
+
+void SaveCreator::resetLog(const std::string& logPath) {
+	const std::string tempPath = logPath + ".tmp";
+	FILE* file = std::fopen(tempPath.c_str(), "wb");
+	if (!file) {
+		throw std::runtime_error("Could not open " + tempPath);
+	}
+	uint8_t header[logHeaderSize] = {};
+	std::memcpy(header, logMagic, sizeof(logMagic));
+	std::memcpy(header + sizeof(logMagic), &logVersion, sizeof(logVersion));
+	bool ok = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+	ok = std::fclose(file) == 0 && ok;
+	if (!ok) {
+		throw std::runtime_error("Failed to write " + tempPath);
+	}
+	flushToDisk(tempPath);
+	replaceFile(tempPath, logPath);
+}
+
+SaveCreator::LogState SaveCreator::appendDelta(World::WorldState& world, const std::string& logPath, const GenerationMarks& saved, LogState state) {
+	if (!std::filesystem::exists(logPath) || state.bytes < logHeaderSize) {
+		resetLog(logPath);
+		state.bytes = logHeaderSize;
+	}
+	// anything past the last commit is a torn append, the log may be mapped so it's cut by
+	// copying the committed part rather than truncating in place
+	if (std::filesystem::file_size(logPath) != state.bytes) {
+		truncateLog(logPath, state.bytes);
+	}
+
+	FILE* file = std::fopen(logPath.c_str(), "ab");
+	if (!file) {
+		throw std::runtime_error("Could not open " + logPath);
+	}
+
+	static const uint8_t padding[chunkAlignment] = {};
+	const uint64_t sequence = state.sequence + 1;
+	uint64_t written = state.bytes;
+	uint32_t records = 0;
+	bool ok = true;
+
+	auto writeRecord = [&](RecordHeader& header, const void* payload) {
+		header.magic = recordMagic;
+		header.sequence = sequence;
+		header.headerChecksum = headerChecksum(header);
+		ok = ok && std::fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+		if (header.payloadBytes) {
+			uint64_t pad = paddedSize(header.payloadBytes) - header.payloadBytes;
+			ok = ok && std::fwrite(payload, 1, header.payloadBytes, file) == header.payloadBytes;
+			ok = ok && std::fwrite(padding, 1, pad, file) == pad;
+		}
+		written += sizeof(header) + paddedSize(header.payloadBytes);
+	};
+
+	world.forEachColumn([&](uint32_t id, auto& column) {
+		using T = typename std::decay_t<decltype(column)>::value_type;
+		auto mark = saved.find(id);
+		uint64_t since = mark == saved.end() ? 0 : mark->second;
+
+		for (size_t c = 0; c < column.chunkCount(); c++) {
+			const auto& chunk = column.getChunk(c);
+			if (chunk.generation <= since) {
+				continue;
+			}
+			RecordHeader header = {};
+			header.kind = CHUNK_RECORD;
+			header.columnId = id;
+			header.chunkIndex = (uint32_t)c;
+			header.columnSize = column.size();
+			header.payloadBytes = chunk.count * sizeof(T);
+			header.elementSize = sizeof(T);
+			header.payloadChecksum = checksum(chunk.data(), header.payloadBytes);
+			writeRecord(header, chunk.data());
+			records++;
+		}
+	});
+
+	if (records == 0) {
+		std::fclose(file);
+		return state;
+	}
+
+	RecordHeader commit = {};
+	commit.kind = COMMIT_RECORD;
+	commit.columnSize = records;
+	writeRecord(commit, nullptr);
+
+	ok = std::fclose(file) == 0 && ok;
+	if (!ok) {
+		throw std::runtime_error("Failed to append to " + logPath);
+	}
+	flushToDisk(logPath);
+	return LogState(sequence, written);
+}
+
+SaveCreator::LogState SaveCreator::replayLog(World::WorldState& world, const std::string& logPath, uint64_t baseSequence) {
+	if (!std::filesystem::exists(logPath)) {
+		return LogState(baseSequence, 0);
+	}
+
+	auto mapped = std::make_shared<MappedFile>(logPath);
+	const uint8_t* bytes = mapped->data();
+	if (mapped->size() < logHeaderSize || std::memcmp(bytes, logMagic, sizeof(logMagic)) != 0) {
+		ERROR(logPath << " is not a save log, ignoring it.");
+		return LogState(baseSequence, 0);
+	}
+
+	uint32_t version;
+	std::memcpy(&version, bytes + sizeof(logMagic), sizeof(version));
+	if (version == 0 || version > logVersion) {
+		ERROR(logPath << " has unsupported log version " << version << ", ignoring it.");
+		return LogState(baseSequence, 0);
+	}
+	const ChecksumFn sum = version < 2 ? legacyChecksum : checksum;
+
+	LogState res(baseSequence, logHeaderSize, version);
+	std::vector<const RecordHeader*> pending;
+	uint64_t pos = logHeaderSize;
+
+	while (pos + sizeof(RecordHeader) <= mapped->size()) {
+		const RecordHeader* header = (const RecordHeader*)(bytes + pos);
+		if (header->magic != recordMagic || header->headerChecksum != headerChecksum(*header, sum)) {
+			break;
+		}
+		uint64_t next = pos + sizeof(RecordHeader) + paddedSize(header->payloadBytes);
+		if (next > mapped->size()) {
+			break;
+		}
+
+		if (header->kind == CHUNK_RECORD) {
+			if (header->payloadChecksum != sum(bytes + pos + sizeof(RecordHeader), header->payloadBytes, 0)) {
+				break;
+			}
+			pending.push_back(header);
+		}
+		else if (header->kind == COMMIT_RECORD) {
+			if (header->sequence > baseSequence) {
+				for (const RecordHeader* record : pending) {
+					const uint8_t* payload = (const uint8_t*)record + sizeof(RecordHeader);
+					world.forEachColumn([&](uint32_t id, auto& column) {
+						using T = typename std::decay_t<decltype(column)>::value_type;
+						if (id != record->columnId || record->elementSize != sizeof(T)) {
+							return;
+						}
+						size_t count = record->payloadBytes / sizeof(T);
+						size_t chunkElements = std::decay_t<decltype(column)>::chunkElements;
+						if (count > chunkElements || (uint64_t)record->chunkIndex * chunkElements + count > record->columnSize) {
+							ERROR("Skipping an inconsistent log record for chunk " << record->chunkIndex);
+							return;
+						}
+						column.replaceChunk(record->chunkIndex, (const T*)payload, count, record->columnSize, mapped);
+					});
+				}
+			}
+			pending.clear();
+			res = LogState(std::max(res.sequence, header->sequence), next, version);
+		}
+		else {
+			break;
+		}
+		pos = next;
+	}
+
+	if (res.bytes < mapped->size()) {
+		DEBUG("Dropped " << mapped->size() - res.bytes << " bytes of uncommitted log from " << logPath);
+	}
+	return res;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "world.h"
+
+namespace SaveCreator {
+	constexpr char logMagic[8] = { 'M', 'G', 'R', 'S', 'L', 'O', 'G', '\0' };
+	constexpr uint32_t logVersion = 2; // 1 used FNV-1a checksums
+	constexpr uint64_t logHeaderSize = 64;
+	constexpr uint32_t recordMagic = World::chunkId("DREC");
+
+	enum RecordKind : uint32_t {
+		CHUNK_RECORD = 1,
+		COMMIT_RECORD = 2
+	};
+
+	/*
+	* The delta log sits next to the save (path + ".log"). Each autosave appends one record per
+	* chunk that changed since the last write, then a commit record with the next sequence number.
+	* Only committed records are replayed, so a torn append is dropped instead of half applied,
+	* and the base file is never written in place.
+	*/
+	struct RecordHeader {
+		uint32_t magic;
+		uint32_t kind;
+		uint32_t columnId;
+		uint32_t chunkIndex;
+		uint64_t sequence;
+		uint64_t columnSize;
+		uint64_t payloadBytes;
+		uint32_t elementSize;
+		uint32_t payloadChecksum;
+		uint32_t headerChecksum; // covers every field above
+		uint8_t reserved[12];
+	};
+	static_assert(sizeof(RecordHeader) == 64, "Records keep their payloads 64 byte aligned.");
+
+	// last committed sequence and the length of the log up to and including its commit record
+	struct LogState {
+		uint64_t sequence;
+		uint64_t bytes;
+		uint32_t version; // logs in an older version are replayed but never appended to
+
+		LogState() : sequence(0), bytes(0), version(logVersion) {}
+		LogState(uint64_t s, uint64_t b, uint32_t v = logVersion) : sequence(s), bytes(b), version(v) {}
+	};
+
+	// column id -> the column's generation when it was last written
+	using GenerationMarks = std::unordered_map<uint32_t, uint64_t>;
+
+	inline std::string logPathFor(const std::string& savePath) { return savePath + ".log"; }
+
+	// CRC32C, continues from seed
+	uint32_t checksum(const void* data, size_t bytes, uint32_t seed = 0);
+	// FNV-1a, what save format 3 and log version 1 and older were checked with
+	uint32_t legacyChecksum(const void* data, size_t bytes, uint32_t seed = 0);
+	void flushToDisk(const std::string& path);
+	// renames from over to, on Windows a target that is still mapped gets moved aside first and keeps its mapping
+	void replaceFile(const std::string& from, const std::string& to);
+	// puts back the newest file replaceFile moved aside when nothing took its place
+	void restoreReplaced(const std::string& path);
+
+	GenerationMarks generationMarks(World::WorldState& world);
+
+	// appends every chunk newer than its column's mark, returns the state after the commit
+	LogState appendDelta(World::WorldState& world, const std::string& logPath, const GenerationMarks& saved, LogState state);
+	void resetLog(const std::string& logPath);
+
+	// applies every commit newer than baseSequence, stopping at the first torn or corrupt record
+	LogState replayLog(World::WorldState& world, const std::string& logPath, uint64_t baseSequence);
+}
@@ -4,13 +4,36 @@
 #include <map>
 #include <cstdint>
 #include <filesystem>
+#include <chrono>
 #include "../include/SFML/Graphics.hpp"
 #include "logging.h"
 #include "save_creator.h"
+#include "save_index.h"
 #include "graphics.h"
 #include "character.h"
+#include "handball_rules.h"
+#include "calendar.h"
+#include "career.h"
+#include "replay.h"
+#include "assets.h"
 
 
 constexpr const char* mainMenuLayerName = "MainMenu";
 constexpr const char* savesMenuLayerName = "SavesMenu";
-constexpr const char* newGameMenuLayerName = "NewGameMenu";
\ No newline at end of file
+constexpr const char* newGameMenuLayerName = "NewGameMenu";
+constexpr const char* savesDirectory = "saves";
+constexpr const char* replaysDirectory = "replays";
+constexpr const char* textureCacheDirectory = "cache";
+
+// frame pacing when vsync isn't honoured, and how often an idle window wakes up anyway
+const sf::Time minFrameTime = sf::microseconds(1000000 / 144);
+const sf::Time idleWakeup = sf::milliseconds(500);
+
+// main thread time per frame for finishing loaded assets, and how often to check on them until they're in
+const sf::Time assetUploadBudget = sf::milliseconds(4);
+const sf::Time assetPollInterval = sf::milliseconds(4);
+
+// reading the frame back for a save thumbnail stalls the main thread, so it's done this rarely
+const sf::Time thumbnailInterval = sf::seconds(300);
+constexpr const char* namesAsset = "names";
+constexpr const char* traitsAsset = "traits";
\ No newline at end of file
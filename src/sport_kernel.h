@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "modes.h"
+
+namespace Match {
+	enum Side : uint8_t {
+		HOME,
+		AWAY
+	};
+
+	enum EventType : uint8_t {
+		SHOT,
+		SCORE,
+		SUBSTITUTION,
+		SUSPENSION,
+		PERIOD_END
+	};
+
+	struct Event {
+		uint16_t second;
+		Side side;
+		EventType type;
+
+		Event(uint16_t s, Side sd, EventType t) : second(s), side(sd), type(t) {}
+	};
+
+	// ratings are in the 0..1 range
+	struct TeamSheet {
+		float attack;
+		float defence;
+		float stamina;
+
+		TeamSheet() : attack(0.5f), defence(0.5f), stamina(0.5f) {}
+		TeamSheet(float a, float d, float s) : attack(a), defence(d), stamina(s) {}
+	};
+
+	struct Result {
+		uint16_t homeScore;
+		uint16_t awayScore;
+		uint16_t homeShots;
+		uint16_t awayShots;
+		uint16_t possessions;
+		std::vector<Event> events;
+
+		Result() : homeScore(0), awayScore(0), homeShots(0), awayShots(0), possessions(0), events({}) {}
+	};
+
+	// each rules header specializes this for its sport
+	template <Modes::SportModes Mode>
+	struct RulesFor;
+
+	/*
+	* Shared simulation loop for sports played on a running clock with alternating possessions.
+	* Every tuning value comes from the Rules struct as a constexpr, so each sport gets its own
+	* instantiation of the loop with the disabled rule branches compiled out.
+	*
+	* A Rules struct has to provide:
+	*	matchSeconds, periods, meanPossessionSeconds, minPossessionSeconds,
+	*	shotChance, conversion, ratingSwing, homeAdvantage, pointsPerScore,
+	*	fatiguePerPossession, periodRecovery,
+	*	rollingSubstitutions, maxSubstitutions, substitutionThreshold, substitutionRecovery,
+	*	suspensionChance, suspensionSeconds, shorthandedPenalty,
+	*	pointsForWin, pointsForDraw (league table)
+	*/
+	template <typename Rules>
+	class ContinuousKernel {
+	private:
+		struct TeamState {
+			float attack;
+			float defence;
+			float stamina;
+			float fitness;
+			uint8_t substitutions;
+			uint16_t shorthandedUntil;
+		};
+
+		static float clampChance(float p) {
+			return std::clamp(p, 0.01f, 0.99f);
+		}
+
+		template <bool PlayByPlay>
+		static void record(Result& res, uint16_t second, Side side, EventType type) {
+			if constexpr (PlayByPlay) {
+				res.events.emplace_back(second, side, type);
+			}
+		}
+
+		static void recover(TeamState& t) {
+			t.fitness = std::min(1.f, t.fitness + Rules::periodRecovery);
+		}
+
+		// fatigue after a possession, with the substitutions it triggers
+		template <bool PlayByPlay>
+		static void tire(TeamState& t, Result& res, uint16_t second, Side side) {
+			t.fitness -= Rules::fatiguePerPossession * (1.5f - t.stamina);
+
+			if constexpr (Rules::rollingSubstitutions) {
+				if (t.fitness < Rules::substitutionThreshold) {
+					t.fitness = std::min(1.f, t.fitness + Rules::substitutionRecovery);
+					t.substitutions++;
+					record<PlayByPlay>(res, second, side, SUBSTITUTION);
+				}
+			}
+			else if constexpr (Rules::maxSubstitutions > 0) {
+				if (t.fitness < Rules::substitutionThreshold && t.substitutions < Rules::maxSubstitutions) {
+					t.fitness = std::min(1.f, t.fitness + Rules::substitutionRecovery);
+					t.substitutions++;
+					record<PlayByPlay>(res, second, side, SUBSTITUTION);
+				}
+			}
+			t.fitness = std::max(t.fitness, 0.3f);
+		}
+
+	public:
+		template <bool PlayByPlay = false>
+		static Result simulate(const TeamSheet& home, const TeamSheet& away, std::mt19937& rng);
+
+		// fitness averaged over the possessions of a match played at mean possession length
+		static float meanFitness(float stamina);
+	};
+
+	template <typename Rules>
+	float ContinuousKernel<Rules>::meanFitness(float stamina) {
+		constexpr uint32_t periodSeconds = Rules::matchSeconds / Rules::periods;
+
+		TeamState t = { 0.f, 0.f, stamina, 1.f, 0, 0 };
+		Result res;
+		float clock = 0.f;
+		uint32_t nextPeriodEnd = periodSeconds;
+		float sum = 0.f;
+		uint32_t possessions = 0;
+
+		// same order as the match loop: clock, period breaks, the possession, then fatigue
+		while (true) {
+			clock += Rules::meanPossessionSeconds;
+			while (clock >= nextPeriodEnd) {
+				if (nextPeriodEnd >= Rules::matchSeconds) {
+					return possessions ? sum / possessions : 1.f;
+				}
+				nextPeriodEnd += periodSeconds;
+				if constexpr (Rules::periods > 1) {
+					recover(t);
+				}
+			}
+			sum += t.fitness;
+			possessions++;
+			tire<false>(t, res, 0, HOME);
+		}
+	}
+
+	template <typename Rules>
+	template <bool PlayByPlay>
+	Result ContinuousKernel<Rules>::simulate(const TeamSheet& home, const TeamSheet& away, std::mt19937& rng) {
+		static_assert(Rules::periods > 0, "A match needs at least one period.");
+		static_assert(Rules::meanPossessionSeconds > Rules::minPossessionSeconds, "Mean possession has to exceed the minimum.");
+
+		constexpr uint32_t periodSeconds = Rules::matchSeconds / Rules::periods;
+		constexpr float extraPossessionSeconds = Rules::meanPossessionSeconds - Rules::minPossessionSeconds;
+
+		std::uniform_real_distribution<float> chance(0.f, 1.f);
+		std::exponential_distribution<float> possessionLength(1.f / extraPossessionSeconds);
+
+		Result res;
+		if constexpr (PlayByPlay) {
+			res.events.reserve(Rules::matchSeconds / Rules::meanPossessionSeconds);
+		}
+
+		TeamState teams[2] = {
+			{ home.attack, home.defence, home.stamina, 1.f, 0, 0 },
+			{ away.attack, away.defence, away.stamina, 1.f, 0, 0 }
+		};
+		uint16_t* scores[2] = { &res.homeScore, &res.awayScore };
+		uint16_t* shots[2] = { &res.homeShots, &res.awayShots };
+
+		uint32_t clock = 0;
+		uint32_t nextPeriodEnd = periodSeconds;
+		uint8_t attacking = rng() & 1;
+
+		while (true) {
+			clock += Rules::minPossessionSeconds + (uint32_t)possessionLength(rng);
+
+			// period boundaries, the last one ends the match
+			while (clock >= nextPeriodEnd) {
+				record<PlayByPlay>(res, (uint16_t)nextPeriodEnd, HOME, PERIOD_END);
+				if (nextPeriodEnd >= Rules::matchSeconds) {
+					return res;
+				}
+				nextPeriodEnd += periodSeconds;
+				if constexpr (Rules::periods > 1) {
+					for (auto& t : teams) {
+						recover(t);
+					}
+				}
+			}
+
+			TeamState& att = teams[attacking];
+			TeamState& def = teams[attacking ^ 1];
+			const Side side = (Side)attacking;
+			res.possessions++;
+
+			float defence = def.defence * def.fitness;
+			if constexpr (Rules::suspensionSeconds > 0) {
+				if (def.shorthandedUntil > clock) {
+					defence -= Rules::shorthandedPenalty;
+				}
+			}
+			float edge = att.attack * att.fitness - defence;
+			if (side == HOME) {
+				edge += Rules::homeAdvantage;
+			}
+
+			if (chance(rng) < clampChance(Rules::shotChance + Rules::ratingSwing * edge)) {
+				(*shots[attacking])++;
+				record<PlayByPlay>(res, (uint16_t)clock, side, SHOT);
+
+				if (chance(rng) < clampChance(Rules::conversion + Rules::ratingSwing * edge)) {
+					*scores[attacking] += Rules::pointsPerScore;
+					record<PlayByPlay>(res, (uint16_t)clock, side, SCORE);
+				}
+			}
+
+			if constexpr (Rules::suspensionSeconds > 0) {
+				if (chance(rng) < Rules::suspensionChance) {
+					def.shorthandedUntil = (uint16_t)(clock + Rules::suspensionSeconds);
+					record<PlayByPlay>(res, (uint16_t)clock, (Side)(attacking ^ 1), SUSPENSION);
+				}
+			}
+
+			for (uint8_t i = 0; i < 2; i++) {
+				tire<PlayByPlay>(teams[i], res, (uint16_t)clock, (Side)i);
+			}
+
+			attacking ^= 1;
+		}
+	}
+}
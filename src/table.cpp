@@ -0,0 +1,242 @@
+#include "table.h"
+#include "thread_pool.h"
+#include <numeric>
+
+std::shared_ptr<const Graphics::TableColumn> Graphics::StringTableColumn::snapshot() const {
+	return std::make_shared<StringTableColumn>(this->title, this->width, std::make_shared<const World::StringColumn>(*this->data));
+}
+
+void Graphics::StringTableColumn::sort(std::vector<uint32_t>& rows, bool descending) const {
+	std::vector<std::pair<std::string, uint32_t>> keyed;
+	keyed.reserve(rows.size());
+	for (uint32_t row : rows) {
+		keyed.push_back({ this->text(row), row });
+	}
+	std::sort(keyed.begin(), keyed.end(), [descending](const auto& a, const auto& b) {
+		const int compared = a.first.compare(b.first);
+		if (compared != 0) {
+			return descending ? compared > 0 : compared < 0;
+		}
+		return a.second < b.second;
+	});
+	for (size_t i = 0; i < keyed.size(); i++) {
+		rows[i] = keyed[i].second;
+	}
+}
+
+Graphics::DataTableBuilder& Graphics::DataTableBuilder::withColumn(std::shared_ptr<const TableColumn> column) {
+	config->columnWidths.push_back(column->width);
+	config->columns.push_back(column);
+	return *this;
+}
+
+Graphics::DataTable* Graphics::DataTableBuilder::build() {
+	if (config->headerHeight == 0.f) {
+		config->headerHeight = config->rowHeight;
+	}
+	auto res = this->arena.make<DataTable>(config, this->arena);
+	if (res->getConfig()->layer) {
+		res->getConfig()->layer->addObject(res);
+	}
+	return res;
+}
+
+Graphics::DataTable::DataTable(DataTableConfig* config, Memory::Arena& arena) : ScrollList(config, arena), config(config), titles({}),
+	order({}), shown({}), sorting(nullptr), sortColumn(SIZE_MAX), descending(false), filter(nullptr), filterInput({}), filtered({}),
+	filterCursor(0), filtering(false) {
+	config->itemCount = [this]() { return this->shown.size(); };
+	config->itemText = [this](size_t item, size_t column) { return this->config->columns[column]->text(this->shown[item]); };
+
+	const unsigned int characterSize = (unsigned int)(config->headerHeight * 0.6f);
+	for (auto& column : config->columns) {
+		sf::Text* title = arena.make<sf::Text>(*Graphics::useMainFont(), column->title, characterSize);
+		title->setStyle(sf::Text::Bold);
+		this->titles.push_back(title);
+	}
+	this->reload();
+}
+
+Graphics::DataTableConfig* Graphics::DataTable::getConfig() {
+	return this->config;
+}
+
+void Graphics::DataTable::reload() {
+	size_t rows = this->config->columns.empty() ? 0 : SIZE_MAX;
+	for (auto& column : this->config->columns) {
+		rows = std::min(rows, column->size());
+	}
+	if (rows == this->order.size()) {
+		return;
+	}
+
+	// new rows go to the end until the sort below is in
+	std::vector<uint32_t> kept;
+	kept.reserve(rows);
+	for (uint32_t row : this->order) {
+		if (row < rows) {
+			kept.push_back(row);
+		}
+	}
+	for (size_t row = this->order.size(); row < rows; row++) {
+		kept.push_back((uint32_t)row);
+	}
+	this->order = std::move(kept);
+
+	if (this->sortColumn != SIZE_MAX) {
+		this->sortBy(this->sortColumn, this->descending);
+	}
+	this->startFilter(false);
+}
+
+void Graphics::DataTable::sortBy(size_t column, bool descending) {
+	if (column >= this->config->columns.size()) {
+		return;
+	}
+	this->sortColumn = column;
+	this->descending = descending;
+	for (size_t i = 0; i < this->titles.size(); i++) {
+		const std::string& title = this->config->columns[i]->title;
+		this->titles[i]->setString(i == column ? title + (descending ? " v" : " ^") : title);
+	}
+
+	// a sort still running is left to finish, its result just isn't looked at anymore
+	auto result = std::make_shared<SortResult>();
+	this->sorting = result;
+	std::shared_ptr<const TableColumn> snapshot = this->config->columns[column]->snapshot();
+	const size_t rows = this->order.size();
+	Jobs::ThreadPool::getPool()->submit([result, snapshot, rows, descending]() {
+		// the pool's workers don't catch, what goes wrong is reported by animate instead
+		try {
+			std::vector<uint32_t> order(rows);
+			std::iota(order.begin(), order.end(), 0u);
+			snapshot->sort(order, descending);
+			result->order = std::move(order);
+		}
+		catch (std::exception& e) {
+			result->error = e.what();
+		}
+		result->ready.store(true, std::memory_order_release);
+	});
+	Renderer::getRender()->startAnimating(this);
+	this->markDirty();
+}
+
+void Graphics::DataTable::setFilter(std::function<bool(uint32_t)> filter, bool narrows) {
+	this->filter = filter;
+	this->startFilter(narrows);
+}
+
+void Graphics::DataTable::startFilter(bool narrows) {
+	if (!this->filter) {
+		this->filtering = false;
+		this->shown = this->order;
+		this->refresh();
+		return;
+	}
+
+	// while a filter is still running, the rows shown are from the one before it, the input
+	// that one runs over is already a superset of what the narrower filter can keep
+	if (!narrows || !this->filtering) {
+		this->filterInput = narrows ? this->shown : this->order;
+	}
+	this->filtered.clear();
+	this->filtered.reserve(this->filterInput.size());
+	this->filterCursor = 0;
+	this->filtering = true;
+	Renderer::getRender()->startAnimating(this);
+}
+
+bool Graphics::DataTable::stepFilter() {
+	sf::Clock clock;
+	while (this->filterCursor < this->filterInput.size()) {
+		const size_t end = std::min(this->filterCursor + filterSlice, this->filterInput.size());
+		for (; this->filterCursor < end; this->filterCursor++) {
+			const uint32_t row = this->filterInput[this->filterCursor];
+			if (this->filter(row)) {
+				this->filtered.push_back(row);
+			}
+		}
+		if (clock.getElapsedTime() >= filterBudget) {
+			return false;
+		}
+	}
+
+	this->shown.swap(this->filtered);
+	this->filtered.clear();
+	this->filterInput.clear();
+	this->filtering = false;
+	this->refresh();
+	return true;
+}
+
+bool Graphics::DataTable::animate(float seconds) {
+	bool busy = ScrollList::animate(seconds);
+
+	if (this->sorting && this->sorting->ready.load(std::memory_order_acquire) && !this->sorting->error.empty()) {
+		// the old order stays up
+		ERROR("Sorting " << this->config->name << " failed. " << this->sorting->error);
+		this->sorting.reset();
+	}
+	if (this->sorting && this->sorting->ready.load(std::memory_order_acquire)) {
+		// rows added while it was sorting aren't in its order, they go to the end
+		std::vector<uint32_t> sorted = std::move(this->sorting->order);
+		for (size_t row = sorted.size(); row < this->order.size(); row++) {
+			sorted.push_back((uint32_t)row);
+		}
+		this->order = std::move(sorted);
+		this->sorting.reset();
+		this->startFilter(false);
+	}
+	if (this->filtering) {
+		this->stepFilter();
+	}
+	return busy || this->sorting || this->filtering;
+}
+
+void Graphics::DataTable::layoutTitles() {
+	const sf::FloatRect frame = this->config->texture->getGlobalBounds();
+	for (size_t i = 0; i < this->titles.size(); i++) {
+		sf::Text* title = this->titles[i];
+		title->setPosition({ frame.position.x + this->columnStart(i) + this->config->rowHeight * 0.25f,
+			frame.position.y + (this->config->headerHeight - title->getCharacterSize()) / 2.f });
+	}
+}
+
+void Graphics::DataTable::batch(SpriteBatch& batch) {
+	if (!this->config->texture || !this->isVisible()) {
+		return;
+	}
+	ScrollList::batch(batch);
+	this->layoutTitles();
+	for (auto title : this->titles) {
+		batch.add(*title);
+	}
+}
+
+void Graphics::DataTable::render(sf::RenderWindow* window) {
+	if (!this->config->texture || !this->isVisible()) {
+		return;
+	}
+	ScrollList::render(window);
+	this->layoutTitles();
+	for (auto title : this->titles) {
+		window->draw(*title);
+	}
+}
+
+void Graphics::DataTable::onPress() {
+	const sf::Vector2f point = (sf::Vector2f)sf::Mouse::getPosition(Renderer::window);
+	const sf::FloatRect frame = this->config->texture->getGlobalBounds();
+	if (!frame.contains(point) || point.y >= this->viewport().position.y) {
+		ScrollList::onPress();
+		return;
+	}
+
+	for (size_t column = 0; column < this->config->columns.size(); column++) {
+		const float start = frame.position.x + this->columnStart(column);
+		if (point.x >= start && point.x < start + this->config->columns[column]->width) {
+			this->sortBy(column, column == this->sortColumn ? !this->descending : false);
+			return;
+		}
+	}
+}
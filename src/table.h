@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include "graphics.h"
+#include "world.h"
+
+namespace Graphics {
+	/*
+	* A column of a DataTable, read straight out of a World column. Sorting goes over a snapshot,
+	* which shares the data's chunks, so the simulation can keep writing while a worker sorts:
+	* the first edit of a shared chunk clones it and the snapshot keeps the old one. The column
+	* is held through a pointer aliasing whatever owns the world, usually the save, so a table
+	* still up when another save is loaded keeps reading the old one.
+	*/
+	class TableColumn {
+	public:
+		std::string title;
+		float width;
+
+		TableColumn(const std::string& title, float width) : title(title), width(width) {}
+		virtual ~TableColumn() = default;
+
+		virtual size_t size() const = 0;
+		virtual std::string text(uint32_t row) const = 0;
+		virtual std::shared_ptr<const TableColumn> snapshot() const = 0;
+		// orders the rows by this column, equal ones keep the lower row first
+		virtual void sort(std::vector<uint32_t>& rows, bool descending) const = 0;
+	};
+
+	template <typename T>
+	class NumberColumn : public TableColumn {
+	private:
+		std::shared_ptr<const World::Column<T>> data;
+		std::function<double(const T&)> key;
+	public:
+		NumberColumn(const std::string& title, float width, std::shared_ptr<const World::Column<T>> data, std::function<double(const T&)> key)
+			: TableColumn(title, width), data(data), key(key) {}
+
+		size_t size() const override { return this->data->size(); }
+
+		std::string text(uint32_t row) const override {
+			if (row >= this->data->size()) {
+				return "";
+			}
+			const double value = this->key((*this->data)[row]);
+			return value == (double)(int64_t)value ? std::to_string((int64_t)value) : std::to_string(value);
+		}
+
+		std::shared_ptr<const TableColumn> snapshot() const override {
+			return std::make_shared<NumberColumn<T>>(this->title, this->width, std::make_shared<const World::Column<T>>(*this->data), this->key);
+		}
+
+		void sort(std::vector<uint32_t>& rows, bool descending) const override {
+			// keys are read once, not on every comparison
+			std::vector<std::pair<double, uint32_t>> keyed;
+			keyed.reserve(rows.size());
+			for (uint32_t row : rows) {
+				keyed.push_back({ row < this->data->size() ? this->key((*this->data)[row]) : 0.0, row });
+			}
+			std::sort(keyed.begin(), keyed.end(), [descending](const auto& a, const auto& b) {
+				if (a.first != b.first) {
+					return descending ? a.first > b.first : a.first < b.first;
+				}
+				return a.second < b.second;
+			});
+			for (size_t i = 0; i < keyed.size(); i++) {
+				rows[i] = keyed[i].second;
+			}
+		}
+	};
+
+	class StringTableColumn : public TableColumn {
+	private:
+		std::shared_ptr<const World::StringColumn> data;
+	public:
+		StringTableColumn(const std::string& title, float width, std::shared_ptr<const World::StringColumn> data) : TableColumn(title, width), data(data) {}
+
+		size_t size() const override { return this->data->size(); }
+		std::string text(uint32_t row) const override { return row < this->data->size() ? this->data->get(row) : ""; }
+		std::shared_ptr<const TableColumn> snapshot() const override;
+		void sort(std::vector<uint32_t>& rows, bool descending) const override;
+	};
+
+	// arithmetic values shown as they are
+	template <typename T>
+	std::shared_ptr<const TableColumn> numberColumn(const std::string& title, float width, std::shared_ptr<const World::Column<T>> data) {
+		static_assert(std::is_arithmetic_v<T>, "Columns of structs need a key.");
+		return std::make_shared<NumberColumn<T>>(title, width, data, [](const T& value) { return (double)value; });
+	}
+
+	// a number picked out of every element, like the points of a standing
+	template <typename T>
+	std::shared_ptr<const TableColumn> numberColumn(const std::string& title, float width, std::shared_ptr<const World::Column<T>> data, std::function<double(const T&)> key) {
+		return std::make_shared<NumberColumn<T>>(title, width, data, key);
+	}
+
+	inline std::shared_ptr<const TableColumn> stringColumn(const std::string& title, float width, std::shared_ptr<const World::StringColumn> data) {
+		return std::make_shared<StringTableColumn>(title, width, data);
+	}
+
+	struct DataTableConfig : public ScrollListConfig {
+		std::vector<std::shared_ptr<const TableColumn>> columns;
+
+		DataTableConfig() : ScrollListConfig(), columns({}) {}
+	};
+
+	/*
+	* World data in sortable, filterable columns, drawn through ScrollList so cells only exist
+	* for the rows in view. A sort runs on the thread pool over snapshots and its order is
+	* swapped in on the first frame after it's done, the old order stays up until then and a
+	* newer sort makes it be thrown away. Filters go over the rows a slice per frame, one that
+	* only narrows the last filter checks just the rows that one kept. Clicking a column's
+	* title sorts by it, clicking it again flips the direction.
+	*/
+	class DataTable : public ScrollList {
+	private:
+		struct SortResult {
+			std::atomic<bool> ready;
+			std::vector<uint32_t> order;
+			// set instead of the order when the sort threw
+			std::string error;
+
+			SortResult() : ready(false), order({}), error("") {}
+		};
+
+		DataTableConfig* config;
+		std::vector<sf::Text*> titles;
+		// every row in sort order, and the ones the filter keeps in the same order
+		std::vector<uint32_t> order;
+		std::vector<uint32_t> shown;
+
+		std::shared_ptr<SortResult> sorting;
+		size_t sortColumn;
+		bool descending;
+
+		std::function<bool(uint32_t)> filter;
+		std::vector<uint32_t> filterInput;
+		std::vector<uint32_t> filtered;
+		size_t filterCursor;
+		bool filtering;
+
+		void startFilter(bool narrows);
+		// false while rows are left for the next frame
+		bool stepFilter();
+		void layoutTitles();
+	public:
+		// main thread time a frame may spend filtering
+		static inline const sf::Time filterBudget = sf::milliseconds(2);
+		static constexpr size_t filterSlice = 1024;
+
+		// the cells and titles are made in the same arena as the table
+		DataTable(DataTableConfig* config, Memory::Arena& arena);
+
+		DataTableConfig* getConfig() override;
+		void render(sf::RenderWindow* window) override;
+		void batch(SpriteBatch& batch) override;
+		// sorts by the title under the mouse, or picks the item like the list does
+		void onPress() override;
+		bool animate(float seconds) override;
+
+		void sortBy(size_t column, bool descending);
+		// a filter that narrows only keeps rows the current one keeps too, nullptr shows every row
+		void setFilter(std::function<bool(uint32_t)> filter, bool narrows = false);
+		// picks up rows added to the data since the table was built
+		void reload();
+
+		size_t shownCount() const { return this->shown.size(); }
+		// the data row behind a shown item
+		uint32_t rowOf(size_t item) const { return this->shown[item]; }
+	};
+
+	class DataTableBuilder : public ScrollListBuilder {
+	private:
+		DataTableConfig* config;
+
+		DataTableBuilder(Memory::Arena& arena, DataTableConfig* config) : ScrollListBuilder(arena, config), config(config) {}
+	public:
+
+		DataTableBuilder(Memory::Arena& arena) : DataTableBuilder(arena, arena.make<DataTableConfig>()) {}
+		DataTableBuilder& withColumn(std::shared_ptr<const TableColumn> column);
+		DataTable* build() override;
+	};
+}
@@ -0,0 +1,169 @@
+#include "thread_pool.h"
+
+namespace Jobs {
+	ThreadPool* ThreadPool::instance = nullptr;
+
+	// index of the worker running on this thread, -1 outside the pool
+	static thread_local ThreadPool* currentPool = nullptr;
+	static thread_local size_t currentWorker = (size_t)-1;
+}
+
+Jobs::ThreadPool::ThreadPool(size_t threadCount) : stopping(false), nextWorker(0), queued(0), pending(0) {
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	this->workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++) {
+		this->workers.push_back(new Worker());
+	}
+
+	this->threads.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++) {
+		this->threads.emplace_back([this, i]() { this->workerLoop(i); });
+	}
+}
+
+Jobs::ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> guard(this->stateLock);
+		this->stopping = true;
+	}
+	this->wake.notify_all();
+
+	for (auto& t : this->threads) {
+		t.join();
+	}
+	for (auto w : this->workers) {
+		delete w;
+	}
+}
+
+void Jobs::ThreadPool::submit(std::function<void()> task) {
+	size_t target;
+	if (currentPool == this) {
+		target = currentWorker;
+	}
+	else {
+		target = this->nextWorker.fetch_add(1, std::memory_order_relaxed) % this->workers.size();
+	}
+
+	// counted before it's published, a worker could otherwise pop it and count it down first
+	{
+		std::lock_guard<std::mutex> guard(this->stateLock);
+		this->queued++;
+		this->pending++;
+	}
+	{
+		std::lock_guard<std::mutex> guard(this->workers[target]->lock);
+		this->workers[target]->tasks.push_back(std::move(task));
+	}
+	this->wake.notify_one();
+}
+
+bool Jobs::ThreadPool::isWorkerThread() const {
+	return currentPool == this;
+}
+
+void Jobs::ThreadPool::waitIdle() {
+	std::unique_lock<std::mutex> guard(this->stateLock);
+	this->idle.wait(guard, [this]() { return this->pending == 0; });
+}
+
+void Jobs::ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+	if (count == 0) {
+		return;
+	}
+
+	struct Batch {
+		std::atomic<size_t> next;
+		std::atomic<size_t> done;
+		const std::function<void(size_t)>* body;
+		size_t count;
+	};
+	auto batch = std::make_shared<Batch>();
+	batch->next = 0;
+	batch->done = 0;
+	batch->body = &body;
+	batch->count = count;
+
+	// body stays alive until done reaches count, helpers that start later find no indices left
+	auto drain = [](Batch& b) {
+		size_t i;
+		while ((i = b.next.fetch_add(1, std::memory_order_relaxed)) < b.count) {
+			(*b.body)(i);
+			if (b.done.fetch_add(1, std::memory_order_acq_rel) + 1 == b.count) {
+				b.done.notify_all();
+			}
+		}
+	};
+
+	const size_t helpers = std::min(count - 1, this->workers.size());
+	for (size_t h = 0; h < helpers; h++) {
+		this->submit([batch, drain]() { drain(*batch); });
+	}
+	drain(*batch);
+
+	size_t finished;
+	while ((finished = batch->done.load(std::memory_order_acquire)) != count) {
+		batch->done.wait(finished);
+	}
+}
+
+bool Jobs::ThreadPool::tryPop(size_t index, std::function<void()>& task) {
+	Worker* w = this->workers[index];
+	std::lock_guard<std::mutex> guard(w->lock);
+	if (w->tasks.empty()) {
+		return false;
+	}
+	task = std::move(w->tasks.back());
+	w->tasks.pop_back();
+	return true;
+}
+
+bool Jobs::ThreadPool::trySteal(size_t thief, std::function<void()>& task) {
+	for (size_t offset = 1; offset < this->workers.size(); offset++) {
+		Worker* w = this->workers[(thief + offset) % this->workers.size()];
+		std::unique_lock<std::mutex> guard(w->lock, std::try_to_lock);
+		if (!guard.owns_lock() || w->tasks.empty()) {
+			continue;
+		}
+		task = std::move(w->tasks.front());
+		w->tasks.pop_front();
+		return true;
+	}
+	return false;
+}
+
+void Jobs::ThreadPool::finishTask() {
+	std::lock_guard<std::mutex> guard(this->stateLock);
+	if (--this->pending == 0) {
+		this->idle.notify_all();
+	}
+}
+
+void Jobs::ThreadPool::workerLoop(size_t index) {
+	currentPool = this;
+	currentWorker = index;
+
+	std::function<void()> task;
+	while (true) {
+		if (this->tryPop(index, task) || this->trySteal(index, task)) {
+			{
+				std::lock_guard<std::mutex> guard(this->stateLock);
+				this->queued--;
+			}
+			task();
+			task = nullptr;
+			this->finishTask();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(this->stateLock);
+		// a steal attempt can miss a locked deque, so only sleep once nothing is queued anywhere
+		this->wake.wait(guard, [this]() { return this->stopping || this->queued > 0; });
+		if (this->stopping && this->queued == 0) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <condition_variable>
+
+namespace Jobs {
+	/*
+	* Work-stealing pool: every worker owns a deque, pops its own work from the back
+	* and steals from the front of the others when it runs dry. Tasks submitted from
+	* a worker stay on that worker's deque, outside submissions are spread round robin.
+	*/
+	class ThreadPool {
+	private:
+		struct Worker {
+			std::deque<std::function<void()>> tasks;
+			std::mutex lock;
+		};
+
+		static ThreadPool* instance;
+
+		std::vector<Worker*> workers;
+		std::vector<std::thread> threads;
+
+		std::atomic<bool> stopping;
+		std::atomic<uint32_t> nextWorker;
+		size_t queued;
+		size_t pending;
+		std::mutex stateLock;
+		std::condition_variable wake;
+		std::condition_variable idle;
+
+		void workerLoop(size_t index);
+		bool tryPop(size_t index, std::function<void()>& task);
+		bool trySteal(size_t thief, std::function<void()>& task);
+		void finishTask();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+	public:
+		explicit ThreadPool(size_t threadCount = 0);
+		~ThreadPool();
+
+		static ThreadPool* getPool() {
+			if (!instance) {
+				instance = new ThreadPool();
+			}
+			return instance;
+		}
+
+		void submit(std::function<void()> task);
+		void waitIdle();
+		// runs body(i) for every i below count and returns once all of them finished,
+		// the calling thread takes indices too so this is safe to call from a worker
+		void parallelFor(size_t count, const std::function<void(size_t)>& body);
+		size_t size() const { return this->threads.size(); }
+		// true on the pool's own workers, where blocking on another task can deadlock
+		bool isWorkerThread() const;
+	};
+}
@@ -0,0 +1,103 @@
+#include "world.h"
+#include "logging.h"
+
+std::string World::StringColumn::get(size_t i) const {
+	uint32_t begin = this->offsets[i];
+	uint32_t end = this->offsets[i + 1];
+	std::string res(end - begin, '\0');
+	this->chars.copyTo(begin, end - begin, res.data());
+	return res;
+}
+
+uint32_t World::StringColumn::add(const std::string& value) {
+	if (this->offsets.empty()) {
+		this->offsets.push_back(0);
+	}
+	this->chars.append(value.data(), value.size());
+	this->offsets.push_back((uint32_t)this->chars.size());
+	return (uint32_t)this->size() - 1;
+}
+
+bool World::StringColumn::valid() const {
+	uint32_t previous = 0;
+	bool ordered = true;
+	this->offsets.forEachChunk([&](const uint32_t* values, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			ordered = ordered && values[i] >= previous;
+			previous = values[i];
+		}
+	});
+	return ordered && previous <= this->chars.size();
+}
+
+bool World::StringColumn::check() {
+	const bool charsIntact = this->chars.check();
+	if (this->offsets.check() && charsIntact) {
+		return true;
+	}
+	for (size_t i = 0; i < this->offsets.size(); i++) {
+		this->offsets.set(i, 0);
+	}
+	return false;
+}
+
+uint64_t World::packTraits(const Character& character) {
+	uint64_t bits = 0;
+	for (auto e : character.currentEmotions) {
+		if (e != Traits::EMOTION_NONE) bits |= 1ull << (emotionBits + (uint8_t)e);
+	}
+	for (auto m : character.motivations) {
+		if (m != Traits::MOTIVATION_NONE) bits |= 1ull << (motivationBits + (uint8_t)m);
+	}
+	for (auto m : character.moralities) {
+		if (m != Traits::MORALITY_NONE) bits |= 1ull << (moralityBits + (uint8_t)m);
+	}
+	for (auto i : character.intelligence) {
+		if (i != Traits::INTELLIGENCE_NONE) bits |= 1ull << (intelligenceBits + (uint8_t)i);
+	}
+	for (auto b : character.background) {
+		if (b != Traits::BACKGROUND_NONE) bits |= 1ull << (backgroundBits + (uint8_t)b);
+	}
+	return bits;
+}
+
+uint32_t World::WorldState::addCharacter(const Character& character, uint16_t club) {
+	uint32_t id = this->characters.names.add(character.name ? *character.name : "");
+	this->characters.personality.push_back((uint8_t)character.personality);
+	this->characters.traits.push_back(packTraits(character));
+	this->characters.club.push_back(club);
+	return id;
+}
+
+uint32_t World::WorldState::addClub(const std::string& name, const Match::TeamSheet& sheet, uint16_t league) {
+	uint32_t id = this->clubs.names.add(name);
+	this->clubs.sheets.push_back(sheet);
+	this->clubs.league.push_back(league);
+	this->stats.standings.push_back(League::Standing());
+	return id;
+}
+
+bool World::WorldState::verify() {
+	bool intact = true;
+	this->forEachColumn([&](uint32_t, auto& column) {
+		intact = column.verify() && intact;
+	});
+	return intact;
+}
+
+bool World::WorldState::check() {
+	// string columns go first, so they can empty their strings before their parts are zeroed
+	bool intact = this->characters.names.check();
+	intact = this->clubs.names.check() && intact;
+	this->forEachColumn([&](uint32_t, auto& column) {
+		intact = column.check() && intact;
+	});
+	if (!intact) {
+		this->damaged = true;
+	}
+	return intact;
+}
+
+void World::reportCorruptChunk(size_t bytes) {
+	ERROR("A " << bytes << " byte save chunk failed its CRC32C, the save file is corrupt.");
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+#include <atomic>
+#include "crc32c.h"
+#include "league.h"
+#include "character.h"
+
+namespace World {
+	enum ChunkIntegrity : uint8_t {
+		INTACT,
+		UNVERIFIED,
+		CORRUPT
+	};
+
+	// logs a chunk whose bytes don't match the checksum it was saved with
+	void reportCorruptChunk(size_t bytes);
+
+	/*
+	* Values are stored in fixed-size chunks held by shared pointers. Copying a column is a
+	* snapshot: both copies share every chunk, and the first edit of a shared chunk clones just
+	* that chunk. A chunk can also view memory owned by something else (a mapped save file),
+	* which is read in place until it's edited and kept alive by every snapshot sharing it. Every edit stamps the chunk with a new
+	* generation, so writers can tell which chunks changed since they last saw them.
+	* A viewed chunk can carry the CRC32C it was saved with. It isn't checked when the file
+	* is opened or when the chunk is read, check() does that once the column is put to use
+	* and swaps any chunk that failed it for zeroes.
+	*/
+	template <typename T>
+	class Column {
+		static_assert(std::is_trivially_copyable_v<T>, "Columns are written and mapped as raw bytes.");
+	public:
+		using value_type = T;
+		static constexpr size_t chunkShift = 12;
+		static constexpr size_t chunkElements = (size_t)1 << chunkShift;
+
+		struct Chunk {
+			std::vector<T> owned;
+			const T* view;
+			// what view points into
+			std::shared_ptr<const void> backing;
+			size_t count;
+			uint64_t generation;
+			uint32_t checksum;
+			mutable std::atomic<uint8_t> integrity;
+
+			const T* data() const {
+				return this->view ? this->view : this->owned.data();
+			}
+
+			// several threads may race to verify the same chunk, only the first one reports it
+			bool verify() const {
+				uint8_t state = this->integrity.load(std::memory_order_acquire);
+				if (state != UNVERIFIED) {
+					return state == INTACT;
+				}
+				const bool intact = Crc32c::compute(this->view, this->count * sizeof(T)) == this->checksum;
+				if (this->integrity.compare_exchange_strong(state, intact ? INTACT : CORRUPT, std::memory_order_acq_rel) && !intact) {
+					reportCorruptChunk(this->count * sizeof(T));
+				}
+				return intact;
+			}
+		};
+
+	private:
+		std::vector<std::shared_ptr<Chunk>> chunks;
+		size_t count;
+		uint64_t generation;
+
+		Chunk& editChunk(size_t index) {
+			std::shared_ptr<Chunk>& chunk = this->chunks[index];
+			if (chunk.use_count() > 1 || chunk->view) {
+				auto copy = std::make_shared<Chunk>();
+				copy->owned.reserve(chunkElements);
+				copy->owned.assign(chunk->data(), chunk->data() + chunk->count);
+				copy->view = nullptr;
+				copy->count = chunk->count;
+				chunk = copy;
+			}
+			chunk->generation = ++this->generation;
+			return *chunk;
+		}
+
+	public:
+		Column() : chunks({}), count(0), generation(0) {}
+
+		size_t size() const { return this->count; }
+		bool empty() const { return this->count == 0; }
+		size_t chunkCount() const { return this->chunks.size(); }
+		const Chunk& getChunk(size_t index) const { return *this->chunks[index]; }
+		uint64_t getGeneration() const { return this->generation; }
+
+		const T& operator[](size_t i) const {
+			return this->chunks[i >> chunkShift]->data()[i & (chunkElements - 1)];
+		}
+
+		void set(size_t i, const T& value) {
+			this->editChunk(i >> chunkShift).owned[i & (chunkElements - 1)] = value;
+		}
+
+		void push_back(const T& value) {
+			if (this->count % chunkElements == 0) {
+				auto chunk = std::make_shared<Chunk>();
+				chunk->owned.reserve(chunkElements);
+				chunk->view = nullptr;
+				chunk->count = 0;
+				this->chunks.push_back(chunk);
+			}
+			Chunk& chunk = this->editChunk(this->chunks.size() - 1);
+			chunk.owned.push_back(value);
+			chunk.count++;
+			this->count++;
+		}
+
+		void append(const T* values, size_t n) {
+			for (size_t i = 0; i < n; i++) {
+				this->push_back(values[i]);
+			}
+		}
+
+		void copyTo(size_t begin, size_t n, T* out) const {
+			while (n > 0) {
+				const Chunk& chunk = *this->chunks[begin >> chunkShift];
+				size_t offset = begin & (chunkElements - 1);
+				size_t take = std::min(n, chunk.count - offset);
+				std::copy(chunk.data() + offset, chunk.data() + offset + take, out);
+				out += take;
+				begin += take;
+				n -= take;
+			}
+		}
+
+		// points every chunk into the given memory, nothing is copied
+		void mapTo(const void* bytes, size_t n, std::shared_ptr<const void> backing, const uint32_t* checksums = nullptr) {
+			this->chunks.clear();
+			this->chunks.reserve((n + chunkElements - 1) / chunkElements);
+			const T* values = (const T*)bytes;
+			for (size_t begin = 0; begin < n; begin += chunkElements) {
+				auto chunk = std::make_shared<Chunk>();
+				chunk->view = values + begin;
+				chunk->backing = backing;
+				chunk->count = std::min(chunkElements, n - begin);
+				chunk->generation = 0;
+				if (checksums) {
+					chunk->checksum = checksums[begin >> chunkShift];
+					chunk->integrity = UNVERIFIED;
+				}
+				this->chunks.push_back(chunk);
+			}
+			this->count = n;
+		}
+
+		// swaps one chunk for a view into external memory and sets the column's new length
+		void replaceChunk(size_t index, const T* values, size_t n, size_t newSize, std::shared_ptr<const void> backing) {
+			const size_t chunksNeeded = (newSize + chunkElements - 1) / chunkElements;
+			while (this->chunks.size() < std::max(chunksNeeded, index + 1)) {
+				auto empty = std::make_shared<Chunk>();
+				empty->view = nullptr;
+				empty->count = 0;
+				empty->generation = 0;
+				this->chunks.push_back(empty);
+			}
+
+			auto chunk = std::make_shared<Chunk>();
+			chunk->view = n ? values : nullptr;
+			chunk->backing = n ? backing : nullptr;
+			chunk->count = n;
+			chunk->generation = 0;
+			this->chunks[index] = chunk;
+
+			this->chunks.resize(chunksNeeded);
+			this->count = newSize;
+		}
+
+		// checks every chunk that hasn't been read yet, false if any of them is corrupt
+		bool verify() const {
+			bool intact = true;
+			for (auto& chunk : this->chunks) {
+				intact = chunk->verify() && intact;
+			}
+			return intact;
+		}
+
+		// verifies what wasn't yet and swaps every corrupt chunk for zeroes, which the next
+		// write puts in the file, false if there was one
+		bool check() {
+			bool intact = true;
+			for (auto& chunk : this->chunks) {
+				if (!chunk->view || chunk->verify()) {
+					continue;
+				}
+				auto zeroed = std::make_shared<Chunk>();
+				zeroed->owned.reserve(chunkElements);
+				zeroed->owned.assign(chunk->count, T());
+				zeroed->view = nullptr;
+				zeroed->count = chunk->count;
+				zeroed->generation = ++this->generation;
+				chunk = zeroed;
+				intact = false;
+			}
+			return intact;
+		}
+
+		template <typename Visitor>
+		void forEachChunk(Visitor&& visit) const {
+			for (auto& chunk : this->chunks) {
+				visit(chunk->data(), chunk->count);
+			}
+		}
+	};
+
+	// strings packed back to back, offsets has one more entry than there are strings
+	struct StringColumn {
+		Column<char> chars;
+		Column<uint32_t> offsets;
+
+		size_t size() const { return this->offsets.empty() ? 0 : this->offsets.size() - 1; }
+		std::string get(size_t i) const;
+		uint32_t add(const std::string& value);
+		// like Column::check, every string reads empty if either column had a corrupt chunk
+		bool check();
+		// offsets that only grow and stay inside chars, get() doesn't check them itself
+		bool valid() const;
+	};
+
+	// first bit of each trait category in the packed trait bitset
+	constexpr uint8_t emotionBits = 0;
+	constexpr uint8_t motivationBits = emotionBits + (uint8_t)Traits::EMOTION_NONE;
+	constexpr uint8_t moralityBits = motivationBits + (uint8_t)Traits::MOTIVATION_NONE;
+	constexpr uint8_t intelligenceBits = moralityBits + (uint8_t)Traits::MORALITY_NONE;
+	constexpr uint8_t backgroundBits = intelligenceBits + (uint8_t)Traits::INTELLIGENCE_NONE;
+	constexpr uint8_t traitBitCount = backgroundBits + (uint8_t)Traits::BACKGROUND_NONE;
+	static_assert(traitBitCount <= 64, "Trait bitset has to fit in 64 bits.");
+
+	uint64_t packTraits(const Character& character);
+
+	struct CharacterColumns {
+		StringColumn names;
+		Column<uint8_t> personality;
+		Column<uint64_t> traits;
+		Column<uint16_t> club;
+	};
+
+	struct ClubColumns {
+		StringColumn names;
+		Column<Match::TeamSheet> sheets;
+		Column<uint16_t> league;
+	};
+
+	struct FixtureColumns {
+		Column<League::Fixture> fixtures;
+		Column<uint16_t> league;
+		Column<uint32_t> day;
+	};
+
+	// season table rows, one per club
+	struct StatColumns {
+		Column<League::Standing> standings;
+	};
+
+	// one row per played match, a career keeps these across seasons for analysis, they aren't saved
+	struct ResultColumns {
+		Column<League::Fixture> fixtures;
+		Column<uint16_t> homeScore;
+		Column<uint16_t> awayScore;
+		Column<uint16_t> league;
+		Column<uint16_t> season;
+	};
+
+	// final table rows, one per club and finished season
+	struct SeasonColumns {
+		Column<League::Standing> standings;
+		Column<uint16_t> club;
+		Column<uint16_t> league;
+		Column<uint16_t> season;
+		Column<uint16_t> rank;
+	};
+
+	struct History {
+		ResultColumns results;
+		SeasonColumns seasons;
+	};
+
+	constexpr uint32_t chunkId(const char (&tag)[5]) {
+		return (uint32_t)tag[0] | ((uint32_t)tag[1] << 8) | ((uint32_t)tag[2] << 16) | ((uint32_t)tag[3] << 24);
+	}
+
+	class WorldState {
+	public:
+		CharacterColumns characters;
+		ClubColumns clubs;
+		FixtureColumns fixtures;
+		StatColumns stats;
+
+		// set once check() found a corrupt chunk, the data it held is lost
+		bool damaged = false;
+
+		uint32_t addCharacter(const Character& character, uint16_t club);
+		uint32_t addClub(const std::string& name, const Match::TeamSheet& sheet, uint16_t league);
+		// checksums every chunk not verified yet without changing anything, safe on a snapshot
+		bool verify();
+		// the main thread calls this before using a loaded world, false if it found new damage
+		bool check();
+
+		// every persisted column with its chunk id, shared by the writers and loaders
+		template <typename Visitor>
+		void forEachColumn(Visitor&& visit) {
+			visit(chunkId("CNMC"), this->characters.names.chars);
+			visit(chunkId("CNMO"), this->characters.names.offsets);
+			visit(chunkId("CPER"), this->characters.personality);
+			visit(chunkId("CTRT"), this->characters.traits);
+			visit(chunkId("CCLB"), this->characters.club);
+			visit(chunkId("KNMC"), this->clubs.names.chars);
+			visit(chunkId("KNMO"), this->clubs.names.offsets);
+			visit(chunkId("KSHT"), this->clubs.sheets);
+			visit(chunkId("KLEA"), this->clubs.league);
+			visit(chunkId("FFIX"), this->fixtures.fixtures);
+			visit(chunkId("FLEA"), this->fixtures.league);
+			visit(chunkId("FDAY"), this->fixtures.day);
+			visit(chunkId("SSTD"), this->stats.standings);
+		}
+	};
+}